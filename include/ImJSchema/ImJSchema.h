@@ -34,9 +34,16 @@
 
 #include "detail/imgui_widgets_t.h"
 #include "detail/json_utils.h"
+#include "detail/compiled_schema.h"
+#include "detail/profiler.h"
+#include "detail/validator.h"
+#include "detail/widget_path.h"
+#include "detail/widget_state.h"
 
 #include <sstream>
 #include <unordered_set>
+#include <unordered_map>
+#include <vector>
 #include <iomanip>
 
 namespace ImJSchema
@@ -44,6 +51,166 @@ namespace ImJSchema
 
 using json = nlohmann::json;
 
+/**
+ * @brief The FormState struct
+ *
+ * State of a single form that persists between frames. Pass it
+ * to drawSchemaWidget( ) so that initializeToDefaults( ) is only run on
+ * the entire value when it is needed, instead of every frame.
+ *
+ * Once the defaults have been applied, only the widgets that are drawn
+ * check their own value, and initialize it if it is null or the
+ * wrong type (eg: a new array item, or an optional property being enabled).
+ *
+ * Call markDirty() if you modify the value outside of drawSchemaWidget( ).
+ * Drawing a different value or schema with the same FormState will
+ * mark it dirty automatically.
+ *
+ * When drawing a compiled schema, the FormState also stores the state of
+ * the widgets (eg: the selected index of an enum, which optional properties
+ * were removed) so a json cache is not needed. Use toJson( ) to view it.
+ *
+ * If a validator is set, the value is validated when the form is dirty,
+ * and only the modified subtree is re-validated after each edit. The
+ * error messages are drawn under the widgets of the invalid values.
+ */
+struct FormState
+{
+    bool defaultsDirty = true;      // initializeToDefaults needs to be called
+                                    //    on the entire value
+    size_t defaultsThreadCount = 1; // threads used to apply the defaults to large
+                                    //    arrays, 0 uses all cores.
+                                    //    See initializeToDefaultsParallel( )
+
+    std::shared_ptr<CompiledValidator const> validator;  // optional, see compileValidator( )
+    ValidationErrors                         errors;     // errors of the value that was last drawn
+
+    void markDirty()
+    {
+        defaultsDirty = true;
+    }
+
+    /**
+     * @brief clear
+     *
+     * Clears the widget states and marks the form dirty
+     */
+    void clear()
+    {
+        _root.reset();
+        _arena.clear();
+        markDirty();
+    }
+
+    /**
+     * @brief toJson
+     * @param S
+     * @return
+     *
+     * Returns the widget states in the same layout as the
+     * json cache. Used for debugging.
+     */
+    json toJson(CompiledSchema const & S) const
+    {
+        if(S.empty())
+            return {};
+        return detail::widgetStateToJson(S, 0, _root);
+    }
+
+    detail::WidgetStateArena _arena;
+    detail::WidgetState      _root;
+
+    // the value/schema that were last drawn with this state
+    void const * _lastValue  = nullptr;
+    void const * _lastSchema = nullptr;
+
+    /**
+     * @brief _applyDefaults
+     * @param value
+     * @param schemaId
+     * @return
+     *
+     * Returns true if the defaults need to be applied to the value
+     * and clears the dirty flag.
+     */
+    bool _applyDefaults(json const & value, void const * schemaId)
+    {
+        if(_lastValue != &value || _lastSchema != schemaId)
+        {
+            _lastValue  = &value;
+            _lastSchema = schemaId;
+            _root.reset();
+            _arena.clear();
+            defaultsDirty = true;
+        }
+        bool d = defaultsDirty;
+        defaultsDirty = false;
+        return d;
+    }
+};
+
+/**
+ * @brief The Context class
+ *
+ * Holds the state that is used while a form is being drawn: the path
+ * to the widget being drawn, which widget was modified and scratch buffers.
+ *
+ * Each form (or each thread/ImGui context) can use its own Context, so forms
+ * can be drawn independently. If no Context is given, drawSchemaWidget( ) uses
+ * a per-thread default context, see getDefaultContext().
+ *
+ * Calling drawSchemaWidget( ) from within a custom widget with the same
+ * context continues the path of the outer form instead of resetting it.
+ */
+struct Context
+{
+    detail::WidgetPath path;        // path of the widget currently being drawn
+    bool widgetModified = false;    // set when a widget has been modified, the
+                                    //    path stops changing once this is set
+    uint32_t depth = 0;             // number of drawSchemaWidget( ) calls
+                                    //    currently using this context
+    std::string scratch;            // scratch buffer for building ImGui ids
+
+    detail::WidgetStateArena * arena = nullptr;   // allocates the widget states of the
+                                                  //    form being drawn
+
+    struct RowHeights
+    {
+        std::vector<float> heights;
+        int                frame = 0;   // ImGui frame the heights were last used
+    };
+    std::unordered_map<ImGuiID, RowHeights> rowHeights;  // measured row heights of arrays with variable
+                                                        //    height items, the arrays which were not
+                                                        //    drawn in the previous frame are removed
+    int rowHeightsFrame = -1;                           // frame the unused row heights were last removed
+
+    ValidationErrors const * errors = nullptr;   // errors of the form being drawn, if it has a validator
+    std::string errorPath;                      // json pointer of the widget currently being drawn,
+                                                //    only built when errors is set
+    bool errorPathRoot = false;                 // the next widget is the root, its label is
+                                                //    not part of the pointer
+
+    uint64_t widgetCount = 0;   // number of widgets drawn with this context, it is never
+                                //    reset, eg: the difference between two frames
+                                //    is the number of widgets drawn in that frame
+
+    WidgetProfiler * profiler = nullptr;    // records the time spent drawing each widget, only
+                                            //    used if IMJSCHEMA_PROFILER is 1
+};
+
+/**
+ * @brief getDefaultContext
+ * @return
+ *
+ * Returns the context used by the current thread when no
+ * context is passed to drawSchemaWidget( )
+ */
+inline Context & getDefaultContext()
+{
+    thread_local Context ctx;
+    return ctx;
+}
+
 /**
  * @brief The WidgetDrawInput class
  *
@@ -60,6 +227,27 @@ struct WidgetDrawInput
     json & cache;               // Reference to json object that can be used
                                 //    to cache intermediate data
     float object_width = 0.0f;  // The how wide to draw the object
+
+    CompiledSchema const * compiled = nullptr;  // Set when drawing a compiled schema
+    uint32_t node = CompiledNode::npos;         //    index of the schema node in compiled->nodes
+
+    Context * ctx = nullptr;    // The context the widget is being drawn with. This
+                                //    is always set when the widget function is called
+
+    detail::WidgetState * state = nullptr;  // Set when drawing a compiled schema, the
+                                            //    typed state of this widget
+
+    /**
+     * @brief getNode
+     * @return
+     *
+     * Returns the compiled node for this widget, or nullptr
+     * if the widget is being drawn from a raw json schema
+     */
+    CompiledNode const * getNode() const
+    {
+        return compiled ? &compiled->nodes[node] : nullptr;
+    }
 };
 /**
  * @brief drawSchemaWidget
@@ -136,6 +324,17 @@ struct WidgetDrawInput
  */
 bool drawSchemaWidget(WidgetDrawInput & in);
 
+/**
+ * @brief drawSchemaWidget
+ * @param in
+ * @param state
+ * @return
+ *
+ * Same as drawSchemaWidget(in), but the defaults are only applied to the
+ * entire value when the state is dirty. See FormState.
+ */
+bool drawSchemaWidget(WidgetDrawInput & in, FormState & state);
+
 /**
  * @brief getModifiedWidgetPath
  * @return
@@ -145,6 +344,83 @@ bool drawSchemaWidget(WidgetDrawInput & in);
  * the json object that was modified
  */
 json::json_pointer getModifiedWidgetPath();
+json::json_pointer getModifiedWidgetPath(Context const & ctx);
+
+/**
+ * @brief compileSchema
+ * @param schema
+ * @param lazyReferences
+ * @return
+ *
+ * Compiles the schema using the widgets in detail::widgets_all.
+ *
+ * Compiling the schema once and drawing the CompiledSchema avoids
+ * looking up the schema properties on every frame.
+ *
+ * If lazyReferences is true, the schema does not need to be expanded
+ * with jsonExpandAllReferences( ) first, each "$ref" is resolved the
+ * first time it is drawn.
+ *
+ * Example:
+ *
+ * static auto compiled = ImJSchema::compileSchema(schema);
+ * static FormState state;
+ *
+ * if( drawSchemaWidget(compiled, value, state) )
+ * {
+ *    std::cout << getModifiedWidgetPath() << std::endl;
+ * }
+ */
+CompiledSchema compileSchema(json schema, bool lazyReferences = false);
+
+/**
+ * @brief drawSchemaWidget
+ * @param schema
+ * @param value
+ * @param state
+ * @param label
+ * @param object_width
+ * @return
+ *
+ * Draws a widget from a compiled schema. Works the same
+ * way as drawSchemaWidget(WidgetDrawInput&, FormState&), but the
+ * state of the widgets is stored in the FormState instead of a json cache.
+ */
+bool drawSchemaWidget(CompiledSchema const & schema, json & value, FormState & state, char const * label = "object", float object_width = 0.0f);
+
+/**
+ * @brief drawSchemaWidget
+ * @param ctx
+ * @param schema
+ * @param value
+ * @param state
+ * @param label
+ * @param object_width
+ * @return
+ *
+ * Draws a compiled schema using the given context instead of
+ * the thread's default context. Use getModifiedWidgetPath(ctx)
+ * to get the path of the modified widget.
+ */
+bool drawSchemaWidget(Context & ctx, CompiledSchema const & schema, json & value, FormState & state, char const * label = "object", float object_width = 0.0f);
+
+/**
+ * @brief drawProfilerWindow
+ * @param profiler
+ * @param title
+ * @param open
+ * @param rows
+ *
+ * Draws a window with the rows hottest widget paths, by the time
+ * spent in them and the widgets drawn within them, and the rows
+ * hottest widget types, by the time spent in the widget itself.
+ * The times and the allocations made by each widget are averaged
+ * over the frames in the profiler.
+ *
+ * The profiler is only filled in if IMJSCHEMA_PROFILER is 1,
+ * see WidgetProfiler.
+ */
+void drawProfilerWindow(WidgetProfiler const & profiler, char const * title = "ImJSchema Profiler", bool * open = nullptr, size_t rows = 25);
 
 
 // detail namespace, used internally
@@ -168,7 +444,7 @@ namespace detail {
  *   schema.ui:order = array of keys specifying order the properties should be drawn in
  *   schema.ui:widget == "header" - draw object with a Collapsable Header
  */
-bool drawSchemaWidget_Object(char const * label, json & objectValue, json const & schema, json & cache, float widget_size);
+bool drawSchemaWidget_Object(Context & ctx, char const * label, json & objectValue, json const & schema, json & cache, float widget_size);
 
 /**
  * @brief toggleButton
@@ -207,8 +483,6 @@ inline bool toggleButton(char const *label, bool *value, ImVec2 btnSize = {0,0})
 }
 
 
-using widget_draw_function_type = std::function<bool(WidgetDrawInput &in) >;
-
 //#define IMJSCHEMA_UNUSED (void)_label; (void)_value; (void)_schema; (void)in.cache; (void)_object_width;
 #define IMJSCHEMA_UNUSED
 
@@ -226,7 +500,7 @@ inline bool SeparatorLine()
     return true;
 }
 
-bool drawSchemaWidget_internal(char const *label, json & propertyValue, json const & propertySchema, json &cache, float object_width = 0.0f);
+bool drawSchemaWidget_internal(Context & ctx, char const *label, json & propertyValue, json const & propertySchema, json &cache, float object_width = 0.0f);
 
 /**
  * @brief drawSchemaWidget_Object
@@ -237,36 +511,78 @@ bool drawSchemaWidget_internal(char const *label, json & propertyValue, json con
  *
  * This is the main function you should be using to draw an object.
  */
-bool drawSchemaWidget_Object(char const * label, json & objectValue, json const & schema, json &cache, float widget_size=0.0f);
+bool drawSchemaWidget_Object(Context & ctx, char const * label, json & objectValue, json const & schema, json &cache, float widget_size=0.0f);
 
-bool drawSchemaWidget_Array(char const *label, json & value, json const & schema, json &cache, float object_width = 0.0f);
+bool drawSchemaWidget_Array(Context & ctx, char const *label, json & value, json const & schema, json &cache, float object_width = 0.0f);
 
+// Compiled schema versions of the functions above
+bool drawSchemaWidget_internal(Context & ctx, char const *label, json & propertyValue, CompiledSchema const & S, uint32_t node, WidgetState &state, float object_width = 0.0f);
+bool drawSchemaWidget_Object(Context & ctx, char const * label, json & objectValue, CompiledSchema const & S, uint32_t node, WidgetState &state, float widget_size=0.0f);
+bool drawSchemaWidget_Array(Context & ctx, char const *label, json & value, CompiledSchema const & S, uint32_t node, WidgetState &state, float object_width = 0.0f);
 
 
-inline bool _nodeWidgetModified = false;
-inline json::json_pointer _path_ptr;
 
-inline void _pushName(std::string const & name)
+inline void _pushName(Context & ctx, std::string_view name)
 {
-    if(!_nodeWidgetModified)
+    if(!ctx.widgetModified)
     {
-        _path_ptr.push_back(name);
+        ctx.path.push(name);
     }
 }
 
-inline void _popName()
+inline void _popName(Context & ctx)
 {
-    if(!_nodeWidgetModified)
+    if(!ctx.widgetModified)
     {
-        _path_ptr.pop_back();
+        ctx.path.pop();
     }
 }
 
-inline bool drawSchemaWidget_enum(char const * label, json & value, json const & schema, json & cache)
+#if IMJSCHEMA_PROFILER
+/**
+ * @brief The _ProfileScope struct
+ *
+ * Records the time spent drawing a widget in the context's
+ * profiler, if it has one.
+ */
+struct _ProfileScope
+{
+    WidgetProfiler * profiler;
+    json const & schema;
+    _ProfileScope(Context & ctx, char const * label, json const & s) : profiler(ctx.profiler), schema(s)
+    {
+        if(profiler)
+            profiler->beginWidget(label);
+    }
+    ~_ProfileScope()
+    {
+        if(profiler)
+        {
+            auto widget = schema.contains(keyword::enum_) ? keyword::enum_ : JValueView(schema, keyword::ui_widget);
+            profiler->endWidget(JValueView(schema, keyword::type), widget);
+        }
+    }
+    _ProfileScope(_ProfileScope const &) = delete;
+    _ProfileScope & operator=(_ProfileScope const &) = delete;
+};
+#endif
+
+/**
+ * @brief drawSchemaWidget_enum
+ * @param label
+ * @param value
+ * @param schema
+ * @param index
+ * @return
+ *
+ * Draws an enum widget. index is the selected index which is kept
+ * between frames. If it is 0xFFFFFFFF, it is found from the value.
+ */
+inline bool drawSchemaWidget_enum(char const * label, json & value, json const & schema, uint32_t & index)
 {
     bool return_value = false;
     ImGuiComboFlags _flags = 0;
-    std::string _label = schema.count("title") == 1 ? schema.at("title").get<std::string>() : std::string();
+    auto _label = JStringRef(schema, keyword::title);
 
     auto _enum      = schema.find("enum");
     auto _enumNames = schema.find("enumNames");
@@ -289,11 +605,6 @@ inline bool drawSchemaWidget_enum(char const * label, json & value, json const &
         _enumNames = _enum;
     }
 
-    if(!cache.is_object())
-        cache = json::object_t();
-
-    uint32_t index = cache.value<uint32_t>("enumIndex", 0xFFFFFFFF );
-
     if(index == 0xFFFFFFFF)
     {
         uint32_t c = 0;
@@ -306,7 +617,6 @@ inline bool drawSchemaWidget_enum(char const * label, json & value, json const &
             {
                 found = true;
                 index = c;
-                cache["enumIndex"] = index;
                 found = true;
                 break;
             }
@@ -316,7 +626,6 @@ inline bool drawSchemaWidget_enum(char const * label, json & value, json const &
         {
             value = _enum->front();
             index = 0;
-            cache["enumIndex"] = index;
         }
     }
     index = std::min<uint32_t>(index, static_cast<uint32_t>(_enum->size())-1 );
@@ -391,7 +700,7 @@ inline bool drawSchemaWidget_enum(char const * label, json & value, json const &
                     {
                         value = _enum->at(i);
                         return_value = true;
-                        cache["enumIndex"] = i;
+                        index = i;
                     }
                 }
 
@@ -410,7 +719,7 @@ inline bool drawSchemaWidget_enum(char const * label, json & value, json const &
     }
     else
     {
-        if(ImGui::BeginCombo( _label.empty() ? label : _label.c_str(), value_str.c_str(), _flags))
+        if(ImGui::BeginCombo( (!_label || _label->empty()) ? label : _label->c_str(), value_str.c_str(), _flags))
         {
             for(uint32_t i=0; i < totalEnums; i++)
             {
@@ -423,7 +732,7 @@ inline bool drawSchemaWidget_enum(char const * label, json & value, json const &
                     {
                         value = _enum->at(i);
                         return_value = true;
-                        cache["enumIndex"] = i;
+                        index = i;
                     }
                 }
             }
@@ -434,7 +743,18 @@ inline bool drawSchemaWidget_enum(char const * label, json & value, json const &
     return return_value;
 }
 
+inline bool drawSchemaWidget_enum(char const * label, json & value, json const & schema, json & cache)
+{
+    if(!cache.is_object())
+        cache = json::object_t();
 
+    uint32_t index = cache.value<uint32_t>("enumIndex", 0xFFFFFFFF );
+    auto prevIndex = index;
+    auto return_value = drawSchemaWidget_enum(label, value, schema, index);
+    if(index != prevIndex)
+        cache["enumIndex"] = index;
+    return return_value;
+}
 
 inline ImVec4 _hexStringToColor(std::string const & col)
 {
@@ -513,12 +833,19 @@ inline auto numeric_input (WidgetDrawInput &in) -> bool
 
     //using value_type = double;
     auto & _val = _value.get_ref<value_type &>();
-    auto step      = _schema.value("ui:step"     , std::numeric_limits<value_type>::max() );
-    auto step_fast = _schema.value("ui:step_fast", std::numeric_limits<value_type>::max() );
+    auto _node = in.getNode();
+
+    auto step      = _node ? _node->template getStep<value_type>()     : _schema.value("ui:step"     , std::numeric_limits<value_type>::max() );
+    auto step_fast = _node ? _node->template getStepFast<value_type>() : _schema.value("ui:step_fast", std::numeric_limits<value_type>::max() );
 
     if(_object_width > 0.0f) ImGui::SetNextItemWidth(_object_width);
     auto _retValue =  Input_T<value_type>("", &_val, step, step_fast);
 
+    if(_node)
+    {
+        _value = std::clamp(_val, _node->template getMinimum<value_type>(), _node->template getMaximum<value_type>());
+        return _retValue;
+    }
     _value = std::clamp(_val,
                         JValue(_schema, "minimum", std::numeric_limits<value_type>::lowest()),
                         JValue(_schema, "maximum", std::numeric_limits<value_type>::max()));
@@ -534,11 +861,14 @@ inline auto numeric_slider (WidgetDrawInput &in) -> bool
     auto & _value = in.value;
     (void)_object_width;
     auto & _val = _value.get_ref<value_type &>();
-    auto minimum = _schema.value("minimum", std::numeric_limits<value_type>::max() );
-    auto maximum = _schema.value("maximum", std::numeric_limits<value_type>::max() );
+    auto _node = in.getNode();
+    auto minimum = _node ? _node->template getMinimum<value_type>() : _schema.value("minimum", std::numeric_limits<value_type>::max() );
+    auto maximum = _node ? _node->template getMaximum<value_type>() : _schema.value("maximum", std::numeric_limits<value_type>::max() );
+    bool hasRange = _node ? (_node->hasMinimum && _node->hasMaximum)
+                          : (minimum < std::numeric_limits<value_type>::max() && maximum < std::numeric_limits<value_type>::max());
 
     if(_object_width > 0.0f) ImGui::SetNextItemWidth(_object_width);
-    if(minimum < std::numeric_limits<value_type>::max() && maximum < std::numeric_limits<value_type>::max() )
+    if(hasRange)
     {
         if(Slider_T<value_type>("", &_val, minimum, maximum))
         {
@@ -560,13 +890,14 @@ inline auto numeric_drag (WidgetDrawInput &in) -> bool
 
     (void)_object_width;
     auto & _val = _value.get_ref<value_type &>();
-    auto minimum = _schema.value("minimum", std::numeric_limits<value_type>::lowest() );
-    auto maximum = _schema.value("maximum", std::numeric_limits<value_type>::max() );
+    auto _node = in.getNode();
+    auto minimum = _node ? _node->template getMinimum<value_type>() : _schema.value("minimum", std::numeric_limits<value_type>::lowest() );
+    auto maximum = _node ? _node->template getMaximum<value_type>() : _schema.value("maximum", std::numeric_limits<value_type>::max() );
 
     if(_object_width > 0.0f) ImGui::SetNextItemWidth(_object_width);
     //if(minimum < std::numeric_limits<value_type>::max() && maximum < std::numeric_limits<value_type>::max() )
     {
-        auto _speed  = _schema.value("ui:speed", 1.0f );
+        auto _speed  = _node ? _node->speed : _schema.value("ui:speed", 1.0f );
         if(Drag_T<value_type>("", &_val, _speed, minimum, maximum))
         {
             _value = std::clamp(_val, minimum, maximum);
@@ -586,6 +917,92 @@ inline void drawSchemaDescription(json const & _schema)
                                  ImJSchema::detail::SeparatorLine();
                              });
 }
+
+/**
+ * @brief drawSchemaDescription
+ * @param in
+ *
+ * Draws the description using the compiled node if
+ * it is available.
+ */
+inline void drawSchemaDescription(WidgetDrawInput const & in)
+{
+    auto _node = in.getNode();
+    if(!_node)
+    {
+        drawSchemaDescription(in.schema);
+        return;
+    }
+    if(_node->description)
+    {
+        ImGui::TextWrapped("%s", _node->description);
+        ImJSchema::detail::SeparatorLine();
+    }
+}
+
+/**
+ * @brief _stringWidgetError
+ * @param schema
+ * @param str
+ * @return
+ *
+ * Returns why str does not match the "pattern", "format", "minLength"
+ * or "maxLength" of the schema, or nullptr if it does. The patterns are
+ * compiled once by getStringMatcherCache(), so this can be called every
+ * frame while the user is typing.
+ */
+inline char const * _stringWidgetError(json const & schema, std::string const & str)
+{
+    if(auto pattern = JStringRef(schema, "pattern"))
+    {
+        auto M = getStringMatcherCache().get(*pattern);
+        if(M && !M->search(str))
+            return "Does not match the pattern";
+    }
+    if(auto format = JStringRef(schema, "format"))
+    {
+        if(!matchesFormat(*format, str))
+            return "Invalid format";
+    }
+    auto minLength = JValue(schema, "minLength", size_t(0));
+    auto maxLength = JValue(schema, "maxLength", std::numeric_limits<size_t>::max());
+    if(minLength > 0 || maxLength < str.size())
+    {
+        size_t length = 0;
+        for(auto c : str)
+            length += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+        if(length < minLength)
+            return "Too short";
+        if(length > maxLength)
+            return "Too long";
+    }
+    return nullptr;
+}
+
+/**
+ * @brief _pushStringWidgetError
+ * @param error
+ *
+ * Draws a red border around the next widget if error is set.
+ * Call _popStringWidgetError after the widget.
+ */
+inline void _pushStringWidgetError(char const * error)
+{
+    if(!error)
+        return;
+    ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(1.0f, 0.35f, 0.35f, 1.0f));
+    ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 1.0f);
+}
+
+inline void _popStringWidgetError(char const * error)
+{
+    if(!error)
+        return;
+    ImGui::PopStyleVar();
+    ImGui::PopStyleColor();
+    if(ImGui::IsItemHovered())
+        ImGui::SetTooltip("%s", error);
+}
 /**
  * @brief getSchemaTitle
  * @param schema
@@ -604,21 +1021,33 @@ inline char const * getSchemaTitle(json const & schema, char const * _default, c
     return it->get_ref<std::string const&>().c_str();
 }
 
+/**
+ * @brief _drawArrayWidget
+ * @param in
+ * @return
+ *
+ * Draws the array with the "array/" widget. Used by the array widgets
+ * which can only draw some arrays (eg: "color" needs 3 or 4 numbers).
+ */
+inline bool _drawArrayWidget(WidgetDrawInput & in);
+
 // This is a list of all the widgets that can be drawn using ImJSchema
 // you may add or remove items as you please.
 //
-// the key for the map must be "[object,number,boolean,integer,string,array]/WIDGET_NAME"
+// the key for the registry must be "[object,number,boolean,integer,string,array]/WIDGET_NAME"
 //
 // ImGui::PushItemWidth(-1) will be called prior to executing any
 // of these functions.
-inline std::map<std::string, widget_draw_function_type > widgets_all {
+inline WidgetRegistry widgets_all {
     {
         "object/",
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            drawSchemaDescription(in.schema);
-            auto returnValue = drawSchemaWidget_Object(in.label, in.value, in.schema, in.cache, in.object_width);
+            drawSchemaDescription(in);
+            if(in.compiled)
+                return drawSchemaWidget_Object(*in.ctx, in.label, in.value, *in.compiled, in.node, *in.state, in.object_width);
+            auto returnValue = drawSchemaWidget_Object(*in.ctx, in.label, in.value, in.schema, in.cache, in.object_width);
             return returnValue;
         }
     },
@@ -627,8 +1056,10 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            drawSchemaDescription(in.schema);
-            auto returnValue = drawSchemaWidget_Object(in.label, in.value, in.schema, in.cache, in.object_width);
+            drawSchemaDescription(in);
+            if(in.compiled)
+                return drawSchemaWidget_Object(*in.ctx, in.label, in.value, *in.compiled, in.node, *in.state, in.object_width);
+            auto returnValue = drawSchemaWidget_Object(*in.ctx, in.label, in.value, in.schema, in.cache, in.object_width);
             return returnValue;
         }
     },
@@ -637,8 +1068,10 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            drawSchemaDescription(in.schema);
-            auto returnValue = drawSchemaWidget_Object(in.label, in.value, in.schema, in.cache, in.object_width);
+            drawSchemaDescription(in);
+            if(in.compiled)
+                return drawSchemaWidget_Object(*in.ctx, in.label, in.value, *in.compiled, in.node, *in.state, in.object_width);
+            auto returnValue = drawSchemaWidget_Object(*in.ctx, in.label, in.value, in.schema, in.cache, in.object_width);
             return returnValue;
         }
     },
@@ -647,8 +1080,10 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            drawSchemaDescription(in.schema);
-            auto returnValue = drawSchemaWidget_Array(in.label, in.value, in.schema, in.cache, in.object_width);
+            drawSchemaDescription(in);
+            if(in.compiled)
+                return drawSchemaWidget_Array(*in.ctx, in.label, in.value, *in.compiled, in.node, *in.state, in.object_width);
+            auto returnValue = drawSchemaWidget_Array(*in.ctx, in.label, in.value, in.schema, in.cache, in.object_width);
             return returnValue;
         }
     },
@@ -661,8 +1096,15 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
             auto minItems = JValue(in.schema, "minItems", 1);
             auto maxItems = JValue(in.schema, "maxItems", 4);
 
+            auto _drawItem = [&](char const * _label, size_t i, float w)
+            {
+                if(in.compiled)
+                    return drawSchemaWidget_internal(*in.ctx, _label, in.value[i], *in.compiled, in.compiled->nodes[in.node].items, in.state->item(*in.ctx->arena, i), w);
+                return drawSchemaWidget_internal(*in.ctx, _label, in.value[i], _item, in.cache[i], w);
+            };
+
             bool returnValue = false;
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
 
             if(minItems != maxItems)
             {
@@ -679,28 +1121,28 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
                 auto w = (W - (totalItems * (t+spacing)) - (totalItems-1)*spacing) / totalItems;
                 ImGui::Text("X");
                 ImGui::SameLine();
-                returnValue |= drawSchemaWidget_internal("0", in.value[0], _item, in.cache[0], w);
+                returnValue |= _drawItem("0", 0, w);
 
                 if(minItems >= 2)
                 {
                     ImGui::SameLine();
                     ImGui::Text("Y");
                     ImGui::SameLine();
-                    returnValue |= drawSchemaWidget_internal("1", in.value[1], _item, in.cache[1], w);
+                    returnValue |= _drawItem("1", 1, w);
                 }
                 if(minItems >= 3)
                 {
                     ImGui::SameLine();
                     ImGui::Text("Z");
                     ImGui::SameLine();
-                    returnValue |= drawSchemaWidget_internal("2", in.value[2], _item, in.cache[2], w);
+                    returnValue |= _drawItem("2", 2, w);
                 }
                 if(minItems >= 4)
                 {
                     ImGui::SameLine();
                     ImGui::Text("W");
                     ImGui::SameLine();
-                    returnValue |= drawSchemaWidget_internal("3", in.value[3], _item, in.cache[3], w);
+                    returnValue |= _drawItem("3", 3, w);
                 }
 
             }
@@ -713,7 +1155,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
 
             bool isInt = false;
             auto & _type = in.schema.at("items").at("type");
@@ -722,16 +1164,16 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
 
             if( _type != "number" && _type != "integer")
             {
-                return detail::widgets_all["array/"](in);
+                return _drawArrayWidget(in);
             }
             isInt = _type.get_ref<std::string const &>()[0] == 'i';
             if(minItems != maxItems)
             {
-                return detail::widgets_all["array/"](in);
+                return _drawArrayWidget(in);
             }
             if(minItems < 3 || minItems > 4)
             {
-                return detail::widgets_all["array/"](in);
+                return _drawArrayWidget(in);
             }
             ImGuiColorEditFlags flags = 0;
 
@@ -795,7 +1237,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
             auto f = numeric_input<double>(in);
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return f;
         }
     },
@@ -805,7 +1247,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
             auto f =  numeric_slider<double>(in);
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return f;
         }
     },
@@ -815,7 +1257,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
             auto f = numeric_drag<double>(in);
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return f;
         }
     },
@@ -825,7 +1267,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
             auto f = numeric_input<int64_t>(in);
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return f;
         }
     },
@@ -835,7 +1277,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
             auto f = numeric_slider<int64_t>(in);
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return f;
         }
     },
@@ -845,7 +1287,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
             auto f = numeric_drag<int64_t>(in);
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return f;
         }
     },
@@ -864,7 +1306,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
                 auto W = i-F;
                 ImGui::Dummy({in.object_width-W, 0});
             }
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return f;
         }
     },
@@ -873,7 +1315,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            const json _sch = {
+            static const json _sch = {
                 {"type", "string"},
                 {"enum", {"False", "True"} }
             };
@@ -882,7 +1324,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
             json jval = _v ? _sch["enum"][1] : _sch["enum"][0];
             bool returnValue = drawSchemaWidget_enum("", jval, _sch, in.cache);
             _v = jval == _sch["enum"][1];
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return returnValue;
         }
     },
@@ -891,7 +1333,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            const json _sch = {
+            static const json _sch = {
                 {"type", "string"},
                 {"enum", {"Disabled", "Enabled"} }
             };
@@ -899,7 +1341,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
             json jval = _v ? _sch["enum"][1] : _sch["enum"][0];
             bool returnValue = drawSchemaWidget_enum("", jval, _sch, in.cache);
             _v = jval == _sch["enum"][1];
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return returnValue;
         }
     },
@@ -908,7 +1350,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         [](WidgetDrawInput &in) -> bool
         {
             IMJSCHEMA_UNUSED
-            const json _sch = {
+            static const json _sch = {
                 {"type", "string"},
                 {"enum", {"No", "Yes"} }
             };
@@ -916,7 +1358,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
             json jval = _v ? _sch["enum"][1] : _sch["enum"][0];
             bool returnValue = drawSchemaWidget_enum("", jval, _sch, in.cache);
             _v = jval == _sch["enum"][1];
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return returnValue;
         }
     },
@@ -928,8 +1370,11 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
             std::string& json_string_ref = in.value.get_ref<std::string&>();
+            auto error = _stringWidgetError(in.schema, json_string_ref);
+            _pushStringWidgetError(error);
             auto t = ImGui::InputText("", &json_string_ref, 0, nullptr, nullptr);
-            drawSchemaDescription(in.schema);
+            _popStringWidgetError(error);
+            drawSchemaDescription(in);
             return t;
         }
     },
@@ -952,7 +1397,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
                 in.value = stream.str();
                 retVal = true;
             }
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return retVal;
         }
     },
@@ -975,7 +1420,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
                 in.value = stream.str();
                 retVal = true;
             }
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             return retVal;
         }
     },
@@ -985,7 +1430,7 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
         {
             IMJSCHEMA_UNUSED
 
-            drawSchemaDescription(in.schema);
+            drawSchemaDescription(in);
             std::string &json_string_ref = in.value.get_ref<std::string&>();
 
             int rows = 5;
@@ -995,13 +1440,174 @@ inline std::map<std::string, widget_draw_function_type > widgets_all {
                           });
 
             auto sy = static_cast<float>(rows) * ImGui::GetTextLineHeight();
+            auto error = _stringWidgetError(in.schema, json_string_ref);
+            _pushStringWidgetError(error);
             auto v =  ImGui::InputTextMultiline("", &json_string_ref, {0,sy}, 0, nullptr, nullptr);
+            _popStringWidgetError(error);
             return v;
         }
     }
 };
 
-inline bool drawSchemaWidget_Array(char const *label, json & value, json const & schema, json & cache, float object_width)
+inline bool _drawArrayWidget(WidgetDrawInput & in)
+{
+    // the id never changes, so it is only looked up once and the
+    // registry is not modified while drawing
+    static auto const id = widgets_all.findId("array", "");
+    auto & drawFunction = widgets_all.get(id);
+    return drawFunction ? drawFunction(in) : false;
+}
+
+/**
+ * @brief The _ArrayRowClipper class
+ *
+ * Used by the array widgets to only draw the rows of the
+ * array table which are visible. Use it the same way as ImGuiListClipper,
+ * but call NextRow(i) instead of ImGui::TableNextRow() and EndTable()
+ * instead of ImGui::EndTable().
+ *
+ *   _ArrayRowClipper rows(ctx, itemCount, fixedHeight);
+ *   while(rows.Step())
+ *   {
+ *       for(size_t i=rows.DisplayStart; i<rows.DisplayEnd; i++)
+ *       {
+ *           rows.NextRow(i);
+ *           ...
+ *       }
+ *   }
+ *   rows.EndTable();
+ *
+ * If all the items have the same height (eg: an array of numbers),
+ * ImGuiListClipper is used. Otherwise the height of each row is stored
+ * in the Context when it is drawn, and the rows that are not visible
+ * are replaced with a single empty row of the same total height. The
+ * heights are removed by _removeUnusedRowHeights( ) once the array is
+ * no longer drawn.
+ */
+class _ArrayRowClipper
+{
+public:
+    size_t DisplayStart = 0;
+    size_t DisplayEnd   = 0;
+
+    _ArrayRowClipper(Context & ctx, size_t itemCount, bool fixedHeight) : m_count(itemCount), m_fixed(fixedHeight)
+    {
+        if(m_fixed)
+        {
+            m_clipper.Begin(static_cast<int>(itemCount));
+            return;
+        }
+
+        auto & R = ctx.rowHeights[ImGui::GetID("rowHeights")];
+        R.frame   = ImGui::GetFrameCount();
+        m_heights = &R.heights;
+        m_heights->resize(itemCount, 0.0f);
+    }
+
+    bool Step()
+    {
+        if(m_fixed)
+        {
+            if(!m_clipper.Step())
+                return false;
+            DisplayStart = static_cast<size_t>(m_clipper.DisplayStart);
+            DisplayEnd   = static_cast<size_t>(m_clipper.DisplayEnd);
+            return true;
+        }
+
+        if(m_step++ != 0)
+        {
+            // fill the space of the rows after the visible ones
+            _skipRows(DisplayEnd, m_count);
+            return false;
+        }
+
+        auto & heights = *m_heights;
+        auto & clip = ImGui::GetCurrentWindow()->ClipRect;
+        auto estimate = ImGui::GetFrameHeightWithSpacing();
+
+        // find the range of rows that overlap the clip rect
+        // using the heights from the previous frames
+        float y = ImGui::GetCurrentTable()->RowPosY2;
+        size_t i = 0;
+        for(; i < m_count; i++)
+        {
+            auto h = heights[i] > 0.0f ? heights[i] : estimate;
+            if(y + h >= clip.Min.y)
+                break;
+            y += h;
+        }
+        DisplayStart = i;
+        for(; i < m_count && y <= clip.Max.y; i++)
+        {
+            y += heights[i] > 0.0f ? heights[i] : estimate;
+        }
+        DisplayEnd = i;
+
+        _skipRows(0, DisplayStart);
+        if(DisplayStart < DisplayEnd)
+            return true;
+        _skipRows(DisplayStart, m_count);
+        return false;
+    }
+
+    void NextRow(size_t i)
+    {
+        ImGui::TableNextRow();
+        if(!m_fixed)
+        {
+            _measure();
+            m_last    = i;
+            m_lastTop = ImGui::GetCurrentTable()->RowPosY1;
+        }
+    }
+
+    void EndTable()
+    {
+        if(m_fixed)
+            m_clipper.End();
+        ImGui::EndTable();
+        if(!m_fixed && m_last < m_heights->size())
+        {
+            (*m_heights)[m_last] = ImGui::GetItemRectMax().y - m_lastTop;
+        }
+    }
+
+protected:
+    void _skipRows(size_t first, size_t last)
+    {
+        float h = 0.0f;
+        auto estimate = ImGui::GetFrameHeightWithSpacing();
+        for(size_t i = first; i < last; i++)
+            h += (*m_heights)[i] > 0.0f ? (*m_heights)[i] : estimate;
+        if(h > 0.0f)
+        {
+            ImGui::TableNextRow(0, h);
+            _measure();
+        }
+    }
+
+    // stores the height of the previously drawn row. The table
+    // is not stored because nested tables can reallocate it
+    void _measure()
+    {
+        if(m_last < m_heights->size())
+        {
+            (*m_heights)[m_last] = ImGui::GetCurrentTable()->RowPosY1 - m_lastTop;
+        }
+        m_last = std::numeric_limits<size_t>::max();
+    }
+
+    size_t              m_count = 0;
+    bool                m_fixed = true;
+    int                 m_step  = 0;
+    ImGuiListClipper    m_clipper;
+    std::vector<float> *m_heights = nullptr;
+    size_t              m_last    = std::numeric_limits<size_t>::max();
+    float               m_lastTop = 0.0f;
+};
+
+inline bool drawSchemaWidget_Array(Context & ctx, char const *label, json & value, json const & schema, json & cache, float object_width)
 {
     (void)object_width;
     auto item_it = schema.find("items");
@@ -1020,11 +1626,11 @@ inline bool drawSchemaWidget_Array(char const *label, json & value, json const &
             ImGui::PushID(&value);
             auto itemCount = value.size();
 
-            while(value.size() < minItems)
+            if(value.size() < minItems)
             {
-                json J;
-                initializeToDefaults(J, _items);
-                value.push_back( std::move(J));
+                if(!value.is_array())
+                    value = json::array_t();
+                value.get_ref<json::array_t&>().resize(minItems, ImJSchema::defaultInstance(_items));
             }
 
             auto full_width = ImGui::GetContentRegionAvail().x;
@@ -1055,65 +1661,72 @@ inline bool drawSchemaWidget_Array(char const *label, json & value, json const &
             bool drawLine = false;
             if(_items.at("type") == "object")
                 drawLine = true;
-            for(size_t i=0;i<itemCount;i++)
-            {
-                auto _label = std::to_string(i);
-
-                ImGui::PushID(static_cast<int>(i));
-                ImGui::TableNextColumn();
 
-                ImGui::SetNextItemWidth(width );
-                ImGui::PushItemWidth(-1);
-                re |= drawSchemaWidget_internal(_label.c_str(), value[i], _items, cache[i]);
-                ImGui::PopItemWidth();
-                if(drawLine && i != itemCount-1)
-                    SeparatorLine();
-                if(showButtons)
+            char _label[24];
+            _ArrayRowClipper rows(ctx, itemCount, !drawLine && _items.at("type") != "array");
+            while(rows.Step())
+            {
+                for(size_t i=rows.DisplayStart;i<rows.DisplayEnd && i<itemCount;i++)
                 {
+                    rows.NextRow(i);
+                    std::snprintf(_label, sizeof(_label), "%zu", i);
+
+                    ImGui::PushID(static_cast<int>(i));
                     ImGui::TableNextColumn();
-                    if(ImGui::Button("x", buttonSize))
-                    {
-                        value.erase(i);
-                        cache.erase(i);
-                        itemCount--;
-                        re |= true;
-                    }
-                    if(ImGui::IsItemHovered())
-                    {
-                        ImGui::SetTooltip("Delete this item");
-                    }
-                    ImGui::SameLine();
-                    if( ImGui::ArrowButton("MoveUp", ImGuiDir_Up) )
+
+                    ImGui::SetNextItemWidth(width );
+                    ImGui::PushItemWidth(-1);
+                    re |= drawSchemaWidget_internal(ctx, _label, value[i], _items, cache[i]);
+                    ImGui::PopItemWidth();
+                    if(drawLine && i != itemCount-1)
+                        SeparatorLine();
+                    if(showButtons)
                     {
-                        if(i!=0)
+                        ImGui::TableNextColumn();
+                        if(ImGui::Button("x", buttonSize))
                         {
-                            std::swap(value.at(i), value.at(i-1));
-                            std::swap(cache.at(i), cache.at(i-1));
+                            value.erase(i);
+                            cache.erase(i);
+                            itemCount--;
+                            re |= true;
                         }
-                        re |= true;
-                    }
-                    if(ImGui::IsItemHovered())
-                    {
-                        ImGui::SetTooltip("Move the item up the list");
-                    }
-                    ImGui::SameLine();
-                    if(ImGui::ArrowButton("MoveDown", ImGuiDir_Down))
-                    {
-                        if(i!=itemCount-1)
+                        if(ImGui::IsItemHovered())
                         {
-                            std::swap(value.at(i), value.at(i+1));
-                            std::swap(cache.at(i), cache.at(i+1));
+                            ImGui::SetTooltip("Delete this item");
                         }
-                        re |= true;
-                    }
-                    if(ImGui::IsItemHovered())
-                    {
-                        ImGui::SetTooltip("Move the item down the list");
-                    }
-                }
-                ImGui::PopID();
+                        ImGui::SameLine();
+                        if( ImGui::ArrowButton("MoveUp", ImGuiDir_Up) )
+                        {
+                            if(i!=0)
+                            {
+                                std::swap(value.at(i), value.at(i-1));
+                                std::swap(cache.at(i), cache.at(i-1));
+                            }
+                            re |= true;
+                        }
+                        if(ImGui::IsItemHovered())
+                        {
+                            ImGui::SetTooltip("Move the item up the list");
+                        }
+                        ImGui::SameLine();
+                        if(ImGui::ArrowButton("MoveDown", ImGuiDir_Down))
+                        {
+                            if(i!=itemCount-1)
+                            {
+                                std::swap(value.at(i), value.at(i+1));
+                                std::swap(cache.at(i), cache.at(i+1));
+                            }
+                            re |= true;
+                        }
+                        if(ImGui::IsItemHovered())
+                        {
+                            ImGui::SetTooltip("Move the item down the list");
+                        }
+                    }
+                    ImGui::PopID();
+                }
             }
-            ImGui::EndTable();
+            rows.EndTable();
 
             if(value.size() < maxItems)
             {
@@ -1121,9 +1734,7 @@ inline bool drawSchemaWidget_Array(char const *label, json & value, json const &
                 ImGui::SameLine();
                 if(ImGui::Button("+", {appendButtonSize, 0}))
                 {
-                    json J;
-                    initializeToDefaults(J, _items);
-                    value.push_back( std::move(J));
+                    value.push_back( ImJSchema::defaultInstance(_items) );
                     re |= true;
                 }
                 if(ImGui::IsItemHovered())
@@ -1139,11 +1750,162 @@ inline bool drawSchemaWidget_Array(char const *label, json & value, json const &
     }
 }
 
-inline bool drawSchemaWidget_internal(char const *label, json & propertyValue, json const & propertySchema, json & cache, float object_width)
+/**
+ * @brief drawSchemaWidget_Array
+ * @param label
+ * @param value
+ * @param S
+ * @param node
+ * @param state
+ * @param object_width
+ * @return
+ *
+ * Draws an array using the compiled schema node.
+ */
+inline bool drawSchemaWidget_Array(Context & ctx, char const *label, json & value, CompiledSchema const & S, uint32_t node, WidgetState & state, float object_width)
+{
+    (void)object_width;
+    (void)label;
+    auto & N = S.nodes[node];
+    if(N.items == CompiledNode::npos)
+        return false;
+
+    auto [IS, itemNode] = resolveNode(S, N.items);
+    auto & _items = IS->nodes[itemNode];
+    auto minItems = N.minItems;
+    auto maxItems = N.maxItems;
+    bool re = false;
+
+    ImGui::PushID(&value);
+    auto itemCount = value.size();
+
+    if(value.size() < minItems)
+    {
+        if(!value.is_array())
+            value = json::array_t();
+        value.get_ref<json::array_t&>().resize(minItems, defaultInstance(*IS, itemNode));
+    }
+
+    auto full_width = ImGui::GetContentRegionAvail().x;
+
+    auto sz = ImGui::GetFrameHeight();
+    ImVec2 buttonSize(sz,sz);
+
+    auto spacing = ImGui::GetStyle().ItemSpacing.x;
+    auto padding = ImGui::GetStyle().FramePadding.x;
+
+    auto width = full_width - 3 * buttonSize.x - 2*spacing - padding;
+
+    bool showButtons = (value.size() > minItems) || (value.size() == 0);
+
+    auto appendButtonSize = full_width - width;
+    if(!showButtons)
+        width = full_width;
+
+    ImGui::BeginTable("arraytable", showButtons ? 2 : 1);
+    ImGui::TableSetupColumn("AAA", ImGuiTableColumnFlags_WidthStretch);
+
+    if(showButtons)
+        ImGui::TableSetupColumn("BBB", ImGuiTableColumnFlags_WidthFixed, full_width-width);
+
+    bool drawLine = _items.type == SchemaType::Object;
+    state.reserveItems(*ctx.arena, itemCount);
+
+    char _label[24];
+    _ArrayRowClipper rows(ctx, itemCount, !drawLine && _items.type != SchemaType::Array);
+    while(rows.Step())
+    {
+        for(size_t i=rows.DisplayStart;i<rows.DisplayEnd && i<itemCount;i++)
+        {
+            rows.NextRow(i);
+            std::snprintf(_label, sizeof(_label), "%zu", i);
+
+            ImGui::PushID(static_cast<int>(i));
+            ImGui::TableNextColumn();
+
+            ImGui::SetNextItemWidth(width );
+            ImGui::PushItemWidth(-1);
+            re |= drawSchemaWidget_internal(ctx, _label, value[i], *IS, itemNode, state.item(*ctx.arena, i));
+            ImGui::PopItemWidth();
+            if(drawLine && i != itemCount-1)
+                SeparatorLine();
+            if(showButtons)
+            {
+                ImGui::TableNextColumn();
+                if(ImGui::Button("x", buttonSize))
+                {
+                    value.erase(i);
+                    state.eraseItem(*ctx.arena, i);
+                    itemCount--;
+                    re |= true;
+                }
+                if(ImGui::IsItemHovered())
+                {
+                    ImGui::SetTooltip("Delete this item");
+                }
+                ImGui::SameLine();
+                if( ImGui::ArrowButton("MoveUp", ImGuiDir_Up) )
+                {
+                    if(i!=0)
+                    {
+                        std::swap(value.at(i), value.at(i-1));
+                        state.swapItems(i, i-1);
+                    }
+                    re |= true;
+                }
+                if(ImGui::IsItemHovered())
+                {
+                    ImGui::SetTooltip("Move the item up the list");
+                }
+                ImGui::SameLine();
+                if(ImGui::ArrowButton("MoveDown", ImGuiDir_Down))
+                {
+                    if(i!=itemCount-1)
+                    {
+                        std::swap(value.at(i), value.at(i+1));
+                        state.swapItems(i, i+1);
+                    }
+                    re |= true;
+                }
+                if(ImGui::IsItemHovered())
+                {
+                    ImGui::SetTooltip("Move the item down the list");
+                }
+            }
+            ImGui::PopID();
+        }
+    }
+    rows.EndTable();
+
+    if(value.size() < maxItems)
+    {
+        ImGui::Dummy({ImGui::GetContentRegionAvail().x - appendButtonSize - spacing, 0});
+        ImGui::SameLine();
+        if(ImGui::Button("+", {appendButtonSize, 0}))
+        {
+            value.push_back( defaultInstance(*IS, itemNode) );
+            re |= true;
+        }
+        if(ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Append a new item to the array");
+        }
+    }
+
+    ImGui::PopID();
+
+    return re;
+}
+
+inline bool drawSchemaWidget_internal(Context & ctx, char const *label, json & propertyValue, json const & propertySchema, json & cache, float object_width)
 {
     bool returnValue = false;
 
-    _pushName(label);
+    _pushName(ctx, label);
+    ++ctx.widgetCount;
+#if IMJSCHEMA_PROFILER
+    _ProfileScope _profile(ctx, label, propertySchema);
+#endif
 
     // check if it is an enum first
     if(propertySchema.contains("enum"))
@@ -1153,32 +1915,117 @@ inline bool drawSchemaWidget_internal(char const *label, json & propertyValue, j
         ImGui::PopItemWidth();
         if(returnValue)
         {
-            _nodeWidgetModified = true;
+            ctx.widgetModified = true;
         }
     }
     else
     {
-        auto _type = JValue(propertySchema, "type", std::string(""));
-        {           
-            auto _widdraw_it = widgets_all.find( _type + "/" + JValue(propertySchema, "ui:widget", std::string("")) );
-            if(_widdraw_it != widgets_all.end() && _widdraw_it->second)
+        auto _type = JValueView(propertySchema, keyword::type);
+        {
+            auto _widdraw = widgets_all.lookup( _type, JValueView(propertySchema, keyword::ui_widget) );
+            if(_widdraw)
             {
                 ImGui::PushItemWidth(-1);
                 ImGui::PushID(&propertyValue);
-                if(propertyValue.is_null())
+                if(!valueMatchesSchemaType(propertyValue, toSchemaType(_type)))
                     initializeToDefaults(propertyValue, propertySchema);
-                WidgetDrawInput in{label, propertyValue, propertySchema, cache, object_width};
-                returnValue = _widdraw_it->second(in);
+                WidgetDrawInput in{label, propertyValue, propertySchema, cache, object_width, nullptr, CompiledNode::npos, &ctx};
+                returnValue = (*_widdraw)(in);
                 if(returnValue)
                 {
-                    _nodeWidgetModified = true;
+                    ctx.widgetModified = true;
                 }
                 ImGui::PopID();
                 ImGui::PopItemWidth();
             }
         }
     }
-    _popName();
+    _popName(ctx);
+
+    return returnValue;
+}
+
+/**
+ * @brief drawSchemaWidget_internal
+ * @param label
+ * @param propertyValue
+ * @param S
+ * @param node
+ * @param state
+ * @param object_width
+ * @return
+ *
+ * Draws the widget for a node in the compiled schema. The widget
+ * draw function was already resolved when the schema was compiled.
+ */
+inline bool drawSchemaWidget_internal(Context & ctx, char const *label, json & propertyValue, CompiledSchema const & S, uint32_t node, WidgetState & state, float object_width)
+{
+    if(S.nodes[node].isRef)
+    {
+        auto [RS, resolved] = resolveNode(S, node);
+        if(!RS->error.empty())
+        {
+            // the reference could not be expanded
+            ImGui::TextColored(ImVec4(1.0f, 0.35f, 0.35f, 1.0f), "%s: %s", label, RS->error.c_str());
+            return false;
+        }
+        return drawSchemaWidget_internal(ctx, label, propertyValue, *RS, resolved, state, object_width);
+    }
+
+    bool returnValue = false;
+    auto & N = S.nodes[node];
+
+    _pushName(ctx, label);
+    ++ctx.widgetCount;
+#if IMJSCHEMA_PROFILER
+    _ProfileScope _profile(ctx, label, *N.schema);
+#endif
+
+    auto errorPathSize = ctx.errorPath.size();
+    if(ctx.errors)
+    {
+        if(ctx.errorPathRoot)
+            ctx.errorPathRoot = false;
+        else
+            _appendPointerToken(ctx.errorPath, label);
+    }
+
+    if(N.isEnum)
+    {
+        ImGui::PushItemWidth(-1);
+        returnValue |= drawSchemaWidget_enum(label, propertyValue, *N.schema, state.enumIndex );
+        ImGui::PopItemWidth();
+        if(returnValue)
+        {
+            ctx.widgetModified = true;
+        }
+    }
+    else if(auto & _widdraw = S.widgets->get(N.widget))
+    {
+        ImGui::PushItemWidth(-1);
+        ImGui::PushID(&propertyValue);
+        if(!valueMatchesSchemaType(propertyValue, N.type))
+            initializeToDefaults(propertyValue, *N.schema);
+        WidgetDrawInput in{label, propertyValue, *N.schema, state.cache, object_width, &S, node, &ctx, &state};
+        returnValue = _widdraw(in);
+        if(returnValue)
+        {
+            ctx.widgetModified = true;
+        }
+        ImGui::PopID();
+        ImGui::PopItemWidth();
+    }
+
+    if(ctx.errors)
+    {
+        if(auto messages = ctx.errors->find(ctx.errorPath))
+        {
+            for(auto & m : *messages)
+                ImGui::TextColored(ImVec4(1.0f, 0.35f, 0.35f, 1.0f), "%s", m.c_str());
+        }
+        ctx.errorPath.resize(errorPathSize);
+    }
+    _popName(ctx);
 
     return returnValue;
 }
@@ -1211,7 +2058,7 @@ void forEachProperty(json const & schema,
     {
         for(auto & _ord : *order_it)
         {
-            auto propertyName      = _ord.get<std::string>();
+            auto & propertyName    = _ord.get_ref<std::string const&>();
             auto propertySchema_it = properties_it->find(propertyName);
 
             if(propertySchema_it == properties_it->end())
@@ -1256,6 +2103,26 @@ inline void drawSchemaToolTip(json const & schema)
                       }
                   });
 }
+/**
+ * @brief _rightAlignedButton
+ * @param _label
+ * @return
+ *
+ * Draws a button which is aligned to the right side
+ * of the available space.
+ */
+inline bool _rightAlignedButton(char const * _label)
+{
+    const auto label_size = ImGui::CalcTextSize(_label, nullptr, true);
+    auto & style = ImGui::GetStyle();
+
+    ImVec2 size = ImGui::CalcItemSize({0,0}, label_size.x + style.FramePadding.x * 2.0f, label_size.y + style.FramePadding.y * 2.0f);
+
+    ImGui::Dummy({ImGui::GetContentRegionAvail().x - size.x - style.ItemSpacing.x, 0});
+    ImGui::SameLine();
+    return ImGui::Button(_label, size);
+}
+
 /**
  * @brief drawSchemaWidget_Object
  * @param label
@@ -1265,7 +2132,7 @@ inline void drawSchemaToolTip(json const & schema)
  *
  * Draw a json object.
  */
-inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & objectValue, json const & schema, json & cache, float widget_size)
+inline bool drawSchemaWidget_Object_withoutOneOf(Context & ctx, char const * label, json & objectValue, json const & schema, json & cache, float widget_size)
 {
     (void)label;
     if(!schema.is_object())
@@ -1350,7 +2217,8 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
         }
     }
 
-    auto currPath = ImJSchema::detail::_path_ptr;
+    auto const pathDepth = ctx.path.size();
+    std::string const * enabledProperty = nullptr;
     bool propertyHasBeenEnabled = false;
     if (ImGui::BeginPopupContextItem("my popup"))
     {
@@ -1377,7 +2245,7 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
                                         propertyValue = {};
                                         optional_items[propertyName] = true;
                                     }
-                                    currPath.push_back(propertyName);
+                                    enabledProperty = &propertyName;
                                     returnValue = true;
                                     propertyHasBeenEnabled = true;
                                 }
@@ -1388,15 +2256,7 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
     if(showAddProperty)
     {
         auto _label = getSchemaTitle(schema, addPropertyStr.c_str(), "ui:addPropertyButtonLabel");
-
-        const auto label_size = ImGui::CalcTextSize(_label, nullptr, true);
-        auto & style = ImGui::GetStyle();
-
-        ImVec2 size = ImGui::CalcItemSize({0,0}, label_size.x + style.FramePadding.x * 2.0f, label_size.y + style.FramePadding.y * 2.0f);
-
-        ImGui::Dummy({ImGui::GetContentRegionAvail().x - size.x - style.ItemSpacing.x, 0});
-        ImGui::SameLine();
-        if(ImGui::Button(_label, size))
+        if(_rightAlignedButton(_label))
         {
             ImGui::OpenPopup("my popup");
         }
@@ -1405,15 +2265,7 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
     if(showReset)
     {
         auto _label = getSchemaTitle(schema, "Reset", "ui:resetButtonLabel");
-
-        const auto label_size = ImGui::CalcTextSize(_label, nullptr, true);
-        auto & style = ImGui::GetStyle();
-
-        ImVec2 size = ImGui::CalcItemSize({0,0}, label_size.x + style.FramePadding.x * 2.0f, label_size.y + style.FramePadding.y * 2.0f);
-
-        ImGui::Dummy({ImGui::GetContentRegionAvail().x - size.x - style.ItemSpacing.x, 0});
-        ImGui::SameLine();
-        if(ImGui::Button(_label, size))
+        if(_rightAlignedButton(_label))
         {
             objectValue = {};
             initializeToDefaults(objectValue, schema);
@@ -1421,14 +2273,15 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
             //ImGui::OpenPopup("my popup");
         }
     }
-    std::string _tableName = std::string("tb") + label;
+    auto & _tableName = ctx.scratch;
+    _tableName.assign("tb").append(label);
     ImGui::BeginTable(_tableName.c_str(), 2, tableFlags, {availWidth, 0.0f});
     ImGui::TableSetupColumn("AAA", C1Flags, C1Width);
     ImGui::TableSetupColumn("BBB", C2Flags, C2Width);
     {
         forEachProperty(schema, objectValue, cache, [&](std::string const & propertyName, json & propertyValue, json const & propertySchema, json & propertyCache)
                         {
-                            auto type = JValue(propertySchema, "type", std::string(""));
+                            auto type = JValueView(propertySchema, keyword::type);
                             auto _title = getSchemaTitle(propertySchema, propertyName.c_str());
 
                             bool hidden = JValue(propertySchema, "ui:hidden", false);
@@ -1446,13 +2299,13 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
 
                             if(type == "object" || type == "array")
                             {
-                                auto ui_widget = JValue(propertySchema, "ui:widget", std::string());
+                                auto ui_widget = JValueView(propertySchema, keyword::ui_widget);
                                 if( ui_widget == "header" )
                                 {
                                     ImGui::EndTable();
 
                                     HeaderText(_title);
-                                    returnValue |= drawSchemaWidget_internal(propertyName.c_str(), propertyValue, propertySchema, propertyCache);
+                                    returnValue |= drawSchemaWidget_internal(ctx, propertyName.c_str(), propertyValue, propertySchema, propertyCache);
 
                                     ImGui::BeginTable("OuterTable", 2, tableFlags, {availWidth, 0.0f});
                                     ImGui::TableSetupColumn("AAA", C1Flags, C1Width);
@@ -1464,7 +2317,7 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
 
                                     if(ImGui::CollapsingHeader(_title, ImGuiTreeNodeFlags_DefaultOpen))
                                     {
-                                        returnValue |= drawSchemaWidget_internal(propertyName.c_str(), propertyValue, propertySchema, propertyCache);
+                                        returnValue |= drawSchemaWidget_internal(ctx, propertyName.c_str(), propertyValue, propertySchema, propertyCache);
                                     }
 
                                     ImGui::BeginTable("OuterTable", 2, tableFlags, {availWidth, 0.0f});
@@ -1477,7 +2330,7 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
                                     ImGui::Text("%s", _title);
                                     drawSchemaToolTip(propertySchema);
                                     ImGui::TableNextColumn();
-                                    returnValue |= drawSchemaWidget_internal(propertyName.c_str(), propertyValue, propertySchema, propertyCache);
+                                    returnValue |= drawSchemaWidget_internal(ctx, propertyName.c_str(), propertyValue, propertySchema, propertyCache);
                                 }
                             }
                             else
@@ -1486,7 +2339,7 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
                                 ImGui::Text("%s", _title);
                                 drawSchemaToolTip(propertySchema);
                                 ImGui::TableNextColumn();
-                                returnValue |= drawSchemaWidget_internal(propertyName.c_str(), propertyValue, propertySchema, propertyCache);
+                                returnValue |= drawSchemaWidget_internal(ctx, propertyName.c_str(), propertyValue, propertySchema, propertyCache);
                             }
                             if(optional_items.is_object())
                                 optional_items.erase(propertyName);
@@ -1500,16 +2353,19 @@ inline bool drawSchemaWidget_Object_withoutOneOf(char const * label, json & obje
 
 
     if(propertyHasBeenEnabled)
-        ImJSchema::detail::_path_ptr = currPath;
+    {
+        ctx.path.truncate(pathDepth);
+        ctx.path.push(*enabledProperty);
+    }
     return returnValue;
 }
 
 
-inline bool drawSchemaWidget_Object(char const * label, json & objectValue, json const & schema, json & cache, float widget_size)
+inline bool drawSchemaWidget_Object(Context & ctx, char const * label, json & objectValue, json const & schema, json & cache, float widget_size)
 {
     auto oneOf_it = schema.find("oneOf");
     if(oneOf_it == schema.end())
-        return drawSchemaWidget_Object_withoutOneOf(label, objectValue, schema, cache, widget_size) ;
+        return drawSchemaWidget_Object_withoutOneOf(ctx, label, objectValue, schema, cache, widget_size) ;
 
     auto _getTitle = [](json::const_iterator &J) -> char const*
     {
@@ -1564,7 +2420,7 @@ inline bool drawSchemaWidget_Object(char const * label, json & objectValue, json
 
         if(it_s != oneOf.end())
         {
-            returnVal |= drawSchemaWidget_Object_withoutOneOf(label, objectValue, *it_s, cache, widget_size) ;
+            returnVal |= drawSchemaWidget_Object_withoutOneOf(ctx, label, objectValue, *it_s, cache, widget_size) ;
         }
     }
 
@@ -1572,30 +2428,457 @@ inline bool drawSchemaWidget_Object(char const * label, json & objectValue, json
     return returnVal;
 }
 
+/**
+ * @brief drawSchemaWidget_Object_withoutOneOf
+ * @param label
+ * @param objectValue
+ * @param S
+ * @param node
+ * @param cache
+ * @param widget_size
+ * @return
+ *
+ * Draw a json object using the compiled schema node. The properties
+ * are already sorted by ui:order and the required flags are
+ * already determined.
+ */
+inline bool drawSchemaWidget_Object_withoutOneOf(Context & ctx, char const * label, json & objectValue, CompiledSchema const & S, uint32_t node, WidgetState & state, float widget_size)
+{
+    auto & N = S.nodes[node];
+    if(N.propertyCount == 0)
+        return false;
+
+    auto _begin = S.properties.begin() + N.firstProperty;
+    auto _end   = _begin + N.propertyCount;
+
+    bool returnValue = false;
+
+    float max_label_size = 0.0f;
+
+    auto C1Width = 25.0f;
+    auto C2Width = 75.0f;
+
+    // if we are given an input widget size, use that as
+    // the total size of the object instead of whatever
+    // is calculated
+    auto availWidth = widget_size > 0.0f ? widget_size : ImGui::GetContentRegionAvail().x;
+
+    auto C1Flags    = ImGuiTableColumnFlags_WidthFixed;
+    auto C2Flags    = ImGuiTableColumnFlags_WidthStretch;
+    auto tableFlags = ImGuiTableFlags_SizingFixedSame | ImGuiTableFlags_SizingFixedSame;
+
+    // get the maximum label size from the state
+    // this will be written during the first draw
+    // cycle.
+    if(state.maxLabelSize > 0.0f)
+        C1Width = state.maxLabelSize;
+    C2Width = availWidth - C1Width;
+
+    tableFlags |= N.resizable ? ImGuiTableFlags_Resizable : 0;
+
+    auto const pathDepth = ctx.path.size();
+    std::string const * enabledProperty = nullptr;
+    bool propertyHasBeenEnabled = false;
+    if (ImGui::BeginPopupContextItem("my popup"))
+    {
+        for(auto P = _begin; P != _end; ++P)
+        {
+            if(P->required)
+                continue;
+
+            auto & propertyName = *P->name;
+            auto [PS, pnode] = resolveNode(S, P->node);
+            auto & propertySchema = PS->nodes[pnode];
+            bool _selected = !(!objectValue.contains(propertyName) || objectValue.at(propertyName).is_null());
+
+            auto _title = propertySchema.title ? propertySchema.title : propertyName.c_str();
+            if(ImGui::Checkbox(_title, &_selected))
+            {
+                auto & propertyValue = objectValue[propertyName];
+                propertyValue = {};
+                if(_selected)
+                {
+                    propertyValue = defaultInstance(*PS, pnode);
+                }
+                else
+                {
+                    state.property(*ctx.arena, S, node, static_cast<uint32_t>(P - _begin)).disabled = true;
+                }
+                enabledProperty = &propertyName;
+                returnValue = true;
+                propertyHasBeenEnabled = true;
+            }
+        }
+        ImGui::EndPopup();
+    }
+    if(N.showAddProperty)
+    {
+        auto _label = getSchemaTitle(*N.schema, "Add", "ui:addPropertyButtonLabel");
+        if(_rightAlignedButton(_label))
+        {
+            ImGui::OpenPopup("my popup");
+        }
+    }
+
+    if(N.showReset)
+    {
+        auto _label = getSchemaTitle(*N.schema, "Reset", "ui:resetButtonLabel");
+        if(_rightAlignedButton(_label))
+        {
+            objectValue = defaultInstance(S, node);
+            state.reset(*ctx.arena);
+        }
+    }
+
+    auto & _tableName = ctx.scratch;
+    _tableName.assign("tb").append(label);
+    ImGui::BeginTable(_tableName.c_str(), 2, tableFlags, {availWidth, 0.0f});
+    ImGui::TableSetupColumn("AAA", C1Flags, C1Width);
+    ImGui::TableSetupColumn("BBB", C2Flags, C2Width);
+
+    auto _drawTableRow = [&](char const * _title, CompiledNode const & propertyNode)
+    {
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", _title);
+        if(propertyNode.help && ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+        {
+            ImGui::SetTooltip("%s", propertyNode.help);
+        }
+        ImGui::TableNextColumn();
+    };
+
+    for(auto P = _begin; P != _end; ++P)
+    {
+        auto & propertyName  = *P->name;
+        auto [PS, pnode]     = resolveNode(S, P->node);
+        auto & propertyNode  = PS->nodes[pnode];
+        auto & propertyValue = objectValue[propertyName];
+        auto & propertyState = state.property(*ctx.arena, S, node, static_cast<uint32_t>(P - _begin));
+        auto _title = propertyNode.title ? propertyNode.title : propertyName.c_str();
+
+        if(propertyNode.hidden)
+            continue;
+
+        if(propertyValue.is_null() && !P->required)
+            continue;
+
+        max_label_size = std::max(max_label_size, ImGui::CalcTextSize(_title).x) + 5;
+
+        bool isContainer = propertyNode.type == SchemaType::Object || propertyNode.type == SchemaType::Array;
+        auto layout = isContainer ? propertyNode.layout : NodeLayout::Row;
+
+        if(layout == NodeLayout::Header)
+        {
+            ImGui::EndTable();
+
+            HeaderText(_title);
+            returnValue |= drawSchemaWidget_internal(ctx, propertyName.c_str(), propertyValue, *PS, pnode, propertyState);
+
+            ImGui::BeginTable("OuterTable", 2, tableFlags, {availWidth, 0.0f});
+            ImGui::TableSetupColumn("AAA", C1Flags, C1Width);
+            ImGui::TableSetupColumn("BBB", C2Flags, C2Width);
+        }
+        else if(layout == NodeLayout::Collapsing)
+        {
+            ImGui::EndTable();
+
+            if(ImGui::CollapsingHeader(_title, ImGuiTreeNodeFlags_DefaultOpen))
+            {
+                returnValue |= drawSchemaWidget_internal(ctx, propertyName.c_str(), propertyValue, *PS, pnode, propertyState);
+            }
+
+            ImGui::BeginTable("OuterTable", 2, tableFlags, {availWidth, 0.0f});
+            ImGui::TableSetupColumn("AAA", C1Flags, C1Width);
+            ImGui::TableSetupColumn("BBB", C2Flags, C2Width);
+        }
+        else
+        {
+            _drawTableRow(_title, propertyNode);
+            returnValue |= drawSchemaWidget_internal(ctx, propertyName.c_str(), propertyValue, *PS, pnode, propertyState);
+        }
+        propertyState.disabled = false;
+    }
+    if(max_label_size > 0.0f)
+        state.maxLabelSize = max_label_size;
+
+    for(auto P = _begin; P != _end; ++P)
+    {
+        if(state.property(*ctx.arena, S, node, static_cast<uint32_t>(P - _begin)).disabled)
+            objectValue.erase(*P->name);
+    }
+    ImGui::EndTable(); // OuterTable
+
+    if(propertyHasBeenEnabled)
+    {
+        ctx.path.truncate(pathDepth);
+        ctx.path.push(*enabledProperty);
+    }
+    return returnValue;
+}
+
+inline bool drawSchemaWidget_Object(Context & ctx, char const * label, json & objectValue, CompiledSchema const & S, uint32_t node, WidgetState & state, float widget_size)
+{
+    auto & N = S.nodes[node];
+    if(N.alternativeCount == 0)
+        return drawSchemaWidget_Object_withoutOneOf(ctx, label, objectValue, S, node, state, widget_size);
+
+    auto _alternatives = S.alternatives.begin() + N.firstAlternative;
+    auto _getTitle = [&](uint32_t i) -> char const*
+    {
+        auto [AS, alt] = resolveNode(S, _alternatives[i]);
+        auto t = AS->nodes[alt].title;
+        return t ? t : "Option";
+    };
+
+    bool returnVal = false;
+
+    auto index = state.oneOfIndex;
+
+    if(index == 0xFFFFFFFF)
+    {
+        auto [AS, alt] = resolveNode(S, _alternatives[0]);
+        initializeToDefaults(objectValue, *AS->nodes[alt].schema);
+        index = 0u;
+    }
+    index = std::min(index, N.alternativeCount-1);
+
+    auto selected = resolveNode(S, _alternatives[index]);
+
+    if(ImGui::BeginCombo("One Of", _getTitle(index)))
+    {
+        for(uint32_t i=0; i < N.alternativeCount; i++)
+        {
+            bool is_selected = index == i;
+            if (ImGui::Selectable( _getTitle(i), is_selected))
+            {
+                if( index != i)
+                {
+                    // the values of the other alternatives are
+                    // kept in the widget's json cache
+                    auto & cachedValue = state.cache["cachedValue"];
+                    state.oneOfIndex = i;
+                    cachedValue[index] = objectValue;
+                    selected = resolveNode(S, _alternatives[i]);
+                    objectValue = cachedValue[i] = objectValue;
+                    initializeToDefaults(objectValue, *selected.first->nodes[selected.second].schema);
+
+                    returnVal = true;
+                }
+            }
+        }
+
+        ImGui::EndCombo();
+    }
+
+    returnVal |= drawSchemaWidget_Object_withoutOneOf(ctx, label, objectValue, *selected.first, selected.second, state, widget_size);
+
+    return returnVal;
+}
+
 } // detail
 
 
+namespace detail
+{
+/**
+ * @brief _removeUnusedRowHeights
+ * @param ctx
+ *
+ * Removes the row heights of the arrays which were not drawn in the
+ * previous frame (eg: removed, or drawn with a different ID), the
+ * first time it is called in a frame.
+ */
+inline void _removeUnusedRowHeights(Context & ctx)
+{
+    auto frame = ImGui::GetFrameCount();
+    if(ctx.rowHeightsFrame == frame)
+        return;
+    ctx.rowHeightsFrame = frame;
+    for(auto it = ctx.rowHeights.begin(); it != ctx.rowHeights.end();)
+    {
+        if(it->second.frame < frame - 1)
+            it = ctx.rowHeights.erase(it);
+        else
+            ++it;
+    }
+}
+
+/**
+ * @brief The _DrawScope struct
+ *
+ * Marks the context as being used for the lifetime of the object.
+ * The path and modified flag are only reset by the outermost
+ * drawSchemaWidget( ) call, so a nested call (eg: from a custom
+ * widget) does not clobber the outer form's state.
+ *
+ * If an arena is given, the widget states are allocated from it
+ * until the scope ends.
+ */
+struct _DrawScope
+{
+    Context & ctx;
+    WidgetStateArena * prevArena;
+    explicit _DrawScope(Context & c, WidgetStateArena * arena = nullptr) : ctx(c), prevArena(c.arena)
+    {
+        if(ctx.depth++ == 0)
+        {
+            ctx.widgetModified = false;
+            ctx.path.clear();
+            _removeUnusedRowHeights(ctx);
+        }
+        if(arena)
+            ctx.arena = arena;
+    }
+    ~_DrawScope()
+    {
+        ctx.arena = prevArena;
+        --ctx.depth;
+    }
+    _DrawScope(_DrawScope const &) = delete;
+    _DrawScope & operator=(_DrawScope const &) = delete;
+};
+}
+
 inline bool drawSchemaWidget(WidgetDrawInput& in)
 {
-    detail::_nodeWidgetModified = false;
-    detail::_path_ptr = json::json_pointer{};
+    auto & ctx = in.ctx ? *in.ctx : getDefaultContext();
+    detail::_DrawScope _scope(ctx);
     initializeToDefaults(in.value, in.schema);
-    return detail::drawSchemaWidget_internal(in.label, in.value, in.schema, in.cache, in.object_width);
+    return detail::drawSchemaWidget_internal(ctx, in.label, in.value, in.schema, in.cache, in.object_width);
+}
+
+inline bool drawSchemaWidget(WidgetDrawInput& in, FormState & state)
+{
+    auto & ctx = in.ctx ? *in.ctx : getDefaultContext();
+    detail::_DrawScope _scope(ctx);
+    if(state._applyDefaults(in.value, &in.schema))
+        initializeToDefaultsParallel(in.value, in.schema, state.defaultsThreadCount);
+    return detail::drawSchemaWidget_internal(ctx, in.label, in.value, in.schema, in.cache, in.object_width);
+}
+
+
+inline CompiledSchema compileSchema(json schema, bool lazyReferences)
+{
+    return compileSchema(std::move(schema), detail::widgets_all, lazyReferences);
+}
+
+inline bool drawSchemaWidget(Context & ctx, CompiledSchema const & schema, json & value, FormState & state, char const * label, float object_width)
+{
+    detail::_DrawScope _scope(ctx, &state._arena);
+    if(schema.empty())
+        return false;
+    bool dirty = state._applyDefaults(value, schema.source.get());
+    if(dirty)
+        initializeToDefaultsParallel(value, *schema.root().schema, state.defaultsThreadCount);
+
+    if(!state.validator)
+        return detail::drawSchemaWidget_internal(ctx, label, value, schema, 0, state._root, object_width);
+
+    // a custom widget may draw another form with the same context
+    auto prevErrors = ctx.errors;
+    auto prevErrorPath = std::move(ctx.errorPath);
+    ctx.errors = dirty || state.errors.empty() ? nullptr : &state.errors;
+    ctx.errorPath.clear();
+    ctx.errorPathRoot = true;
+
+    auto pathStart   = ctx.path.size();
+    auto wasModified = ctx.widgetModified;
+    auto modified = detail::drawSchemaWidget_internal(ctx, label, value, schema, 0, state._root, object_width);
+
+    ctx.errors = prevErrors;
+    ctx.errorPath = std::move(prevErrorPath);
+    ctx.errorPathRoot = false;
+
+    // the widgets finish initializing the value (eg: enums select their
+    // first item) the first time they are drawn, so validate it afterwards
+    if(dirty)
+    {
+        validate(*state.validator, value, state.errors);
+    }
+    else if(modified)
+    {
+        // the same as getModifiedWidgetPath(ctx), but relative to this
+        // form in case it is drawn within another form
+        if(!wasModified && ctx.path.size() > pathStart)
+            revalidate(*state.validator, value, ctx.path.toPointer(pathStart + 1), state.errors);
+        else
+            validate(*state.validator, value, state.errors);
+    }
+    return modified;
+}
+
+inline bool drawSchemaWidget(CompiledSchema const & schema, json & value, FormState & state, char const * label, float object_width)
+{
+    return drawSchemaWidget(getDefaultContext(), schema, value, state, label, object_width);
 }
 
+inline json::json_pointer getModifiedWidgetPath(Context const & ctx)
+{
+    // the first entry is the label of the root widget,
+    // which is not part of the value's path
+    if(ctx.path.size() > 1)
+        return ctx.path.toPointer(1);
+    return ctx.path.toPointer();
+}
 
 inline json::json_pointer getModifiedWidgetPath()
 {
-    auto str = detail::_path_ptr.to_string();
-    if(str.front() == '/')
+    return getModifiedWidgetPath(getDefaultContext());
+}
+
+namespace detail
+{
+inline void _drawProfilerTable(char const * id, WidgetProfiler::stats_map const & stats, size_t frames, size_t rows, bool self)
+{
+    auto tableFlags = ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable;
+    if(!ImGui::BeginTable(id, 6, tableFlags))
+        return;
+
+    ImGui::TableSetupColumn(id, ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("calls/frame", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("incl us/frame", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("self us/frame", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("allocs/frame", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("bytes/frame", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableHeadersRow();
+
+    auto f = static_cast<double>(std::max<size_t>(frames, 1));
+    for(auto & [key, s] : WidgetProfiler::hottest(stats, rows, self))
     {
-        auto i = str.find_first_of('/',1);
-        if( i != std::string::npos)
-        {
-            return json::json_pointer( str.substr(i));
-        }
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(key.data(), key.data() + key.size());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", static_cast<double>(s.calls) / f);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", static_cast<double>(s.inclusiveNs) / f * 1e-3);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", static_cast<double>(s.selfNs) / f * 1e-3);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", static_cast<double>(s.allocs.count) / f);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f", static_cast<double>(s.allocs.bytes) / f);
+    }
+    ImGui::EndTable();
+}
+}
+
+inline void drawProfilerWindow(WidgetProfiler const & profiler, char const * title, bool * open, size_t rows)
+{
+    if(ImGui::Begin(title, open))
+    {
+#if !IMJSCHEMA_PROFILER
+        ImGui::TextDisabled("Define IMJSCHEMA_PROFILER=1 to record the widgets");
+#endif
+        ImGui::Text("%zu frames", profiler.frameCount());
+
+        ImGui::SeparatorText("Paths");
+        detail::_drawProfilerTable("path", profiler.paths(), profiler.frameCount(), rows, false);
+
+        ImGui::SeparatorText("Widgets");
+        detail::_drawProfilerTable("type/widget", profiler.widgets(), profiler.frameCount(), rows, true);
     }
-    return detail::_path_ptr;
+    ImGui::End();
 }
 
 }
@@ -0,0 +1,155 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the allocation counters used to find the heap
+// allocations made while drawing a form. Most of them are made by
+// nlohmann json and the std containers with the default allocator, so
+// they are counted in the global operator new:
+//
+//  - define IMJSCHEMA_IMPLEMENT_ALLOCATION_HOOKS in exactly one
+//    translation unit before including this header to replace the
+//    global operator new/delete with ones that count each allocation, or
+//
+//  - call countAllocation(bytes) from your own operator new or
+//    allocator, eg: if it is already replaced by a memory tracker.
+//
+#ifndef IMJSCHEMA_ALLOCATION_HOOKS_H
+#define IMJSCHEMA_ALLOCATION_HOOKS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ImJSchema
+{
+
+/**
+ * @brief The AllocationStats struct
+ *
+ * The number of allocations and the number of bytes allocated.
+ */
+struct AllocationStats
+{
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    AllocationStats & operator+=(AllocationStats const & o)
+    {
+        count += o.count;
+        bytes += o.bytes;
+        return *this;
+    }
+    AllocationStats & operator-=(AllocationStats const & o)
+    {
+        count -= o.count;
+        bytes -= o.bytes;
+        return *this;
+    }
+    friend AllocationStats operator-(AllocationStats a, AllocationStats const & b)
+    {
+        return a -= b;
+    }
+};
+
+/**
+ * @brief threadAllocationStats
+ * @return
+ *
+ * The allocations counted on the calling thread since it started. The
+ * allocations made while drawing a frame are the difference between
+ * the counters before and after it:
+ *
+ *  auto before = threadAllocationStats();
+ *  drawSchemaWidget(compiled, value, state);
+ *  auto frame  = threadAllocationStats() - before;
+ *
+ * The counters stay at zero unless the allocations are counted, see
+ * countAllocation( ).
+ */
+inline AllocationStats & threadAllocationStats() noexcept
+{
+    // constant initialized, so it can be used within operator new
+    thread_local AllocationStats stats;
+    return stats;
+}
+
+/**
+ * @brief countAllocation
+ * @param bytes
+ *
+ * Adds an allocation to the calling thread's counters.
+ */
+inline void countAllocation(std::size_t bytes) noexcept
+{
+    auto & s = threadAllocationStats();
+    s.count += 1;
+    s.bytes += bytes;
+}
+
+}
+
+#endif
+
+#if defined(IMJSCHEMA_IMPLEMENT_ALLOCATION_HOOKS) && !defined(IMJSCHEMA_ALLOCATION_HOOKS_IMPLEMENTED)
+#define IMJSCHEMA_ALLOCATION_HOOKS_IMPLEMENTED
+
+#include <cstdlib>
+#include <new>
+
+// GCC warns about std::free being called on memory from operator new
+// if it can see both, so they are kept out of line
+#if defined(__GNUC__)
+#define IMJSCHEMA_NOINLINE __attribute__((noinline))
+#else
+#define IMJSCHEMA_NOINLINE
+#endif
+
+namespace ImJSchema
+{
+namespace detail
+{
+IMJSCHEMA_NOINLINE inline void * _countedAllocation(std::size_t n)
+{
+    countAllocation(n);
+    if(auto p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+IMJSCHEMA_NOINLINE inline void _countedFree(void * p) noexcept
+{
+    std::free(p);
+}
+}
+}
+
+void * operator new(std::size_t n)   { return ImJSchema::detail::_countedAllocation(n); }
+void * operator new[](std::size_t n) { return ImJSchema::detail::_countedAllocation(n); }
+void operator delete(void * p) noexcept   { ImJSchema::detail::_countedFree(p); }
+void operator delete[](void * p) noexcept { ImJSchema::detail::_countedFree(p); }
+void operator delete(void * p, std::size_t) noexcept   { ImJSchema::detail::_countedFree(p); }
+void operator delete[](void * p, std::size_t) noexcept { ImJSchema::detail::_countedFree(p); }
+
+#undef IMJSCHEMA_NOINLINE
+
+#endif
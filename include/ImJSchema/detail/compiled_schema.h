@@ -0,0 +1,708 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the compiled representation of a json schema.
+//
+// A schema is compiled once into a flat array of nodes so that the draw
+// functions do not have to look up "type", "ui:widget", "title", etc
+// from the json object on every frame.
+//
+#ifndef IMJSCHEMA_COMPILED_SCHEMA_H
+#define IMJSCHEMA_COMPILED_SCHEMA_H
+
+#include "json_utils.h"
+#include "widget_registry.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ImJSchema
+{
+
+/**
+ * @brief The SchemaType enum
+ *
+ * The value of the "type" property of a schema
+ */
+enum class SchemaType : uint8_t
+{
+    Unknown,
+    Object,
+    Array,
+    Number,
+    Integer,
+    Boolean,
+    String
+};
+
+/**
+ * @brief The NodeLayout enum
+ *
+ * How an object/array property is laid out inside its parent object.
+ * This is determined by "ui:widget" being "header" or "collapsing"
+ */
+enum class NodeLayout : uint8_t
+{
+    Row,
+    Header,
+    Collapsing
+};
+
+/**
+ * @brief toSchemaType
+ * @param type
+ * @return
+ *
+ * Converts the "type" string of a schema into a SchemaType
+ */
+inline SchemaType toSchemaType(std::string_view type)
+{
+    if(type == "object")  return SchemaType::Object;
+    if(type == "array")   return SchemaType::Array;
+    if(type == "number")  return SchemaType::Number;
+    if(type == "integer") return SchemaType::Integer;
+    if(type == "boolean") return SchemaType::Boolean;
+    if(type == "string")  return SchemaType::String;
+    return SchemaType::Unknown;
+}
+
+/**
+ * @brief valueMatchesSchemaType
+ * @param value
+ * @param type
+ * @return
+ *
+ * Returns true if the json value is of the type described by the
+ * schema type. If this returns true, initializeToDefaults( ) will not
+ * modify a boolean, number, integer or string value.
+ */
+inline bool valueMatchesSchemaType(json const & value, SchemaType type)
+{
+    switch(type)
+    {
+        case SchemaType::Object:  return value.is_object();
+        case SchemaType::Array:   return value.is_array();
+        case SchemaType::Number:  return value.is_number();
+        case SchemaType::Integer: return value.is_number_integer();
+        case SchemaType::Boolean: return value.is_boolean();
+        case SchemaType::String:  return value.is_string();
+        case SchemaType::Unknown: return true;
+    }
+    return true;
+}
+
+struct CompiledSchema;
+
+/**
+ * @brief The CompiledNode struct
+ *
+ * A single schema object with all the properties the draw
+ * functions need already extracted.
+ *
+ * All char pointers point into the source schema owned by
+ * the CompiledSchema, and are nullptr if the property
+ * does not exist.
+ */
+struct CompiledNode
+{
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    json const * schema = nullptr; // the schema object this node was compiled from
+
+    // the id of "type/ui:widget" in the widget registry
+    detail::WidgetRegistry::id_type widget = detail::WidgetRegistry::npos;
+
+    char const * title       = nullptr;
+    char const * description = nullptr;
+    char const * help        = nullptr;
+
+    SchemaType type   = SchemaType::Unknown;
+    NodeLayout layout = NodeLayout::Row;
+
+    bool hidden          = false; // ui:hidden
+    bool isEnum          = false; // the schema contains "enum"
+    bool showReset       = false; // ui:showReset
+    bool resizable       = false; // ui:resizable
+    bool showAddProperty = false; // "required" does not list all properties
+
+    // numeric properties
+    bool    hasMinimum = false;
+    bool    hasMaximum = false;
+    double  minimum    = std::numeric_limits<double>::lowest();
+    double  maximum    = std::numeric_limits<double>::max();
+    int64_t iminimum   = std::numeric_limits<int64_t>::lowest();
+    int64_t imaximum   = std::numeric_limits<int64_t>::max();
+    double  step       = std::numeric_limits<double>::max(); // ui:step
+    double  step_fast  = std::numeric_limits<double>::max(); // ui:step_fast
+    float   speed      = 1.0f;                               // ui:speed
+
+    // array properties
+    uint32_t items    = npos;  // node index of the "items" schema
+    size_t   minItems = 0;
+    size_t   maxItems = std::numeric_limits<size_t>::max();
+
+    // object properties, range within CompiledSchema::properties
+    uint32_t firstProperty = 0;
+    uint32_t propertyCount = 0;
+
+    // oneOf alternatives, range within CompiledSchema::alternatives
+    uint32_t firstAlternative = 0;
+    uint32_t alternativeCount = 0;
+
+    // an unresolved "$ref", only used when the schema was compiled
+    // with lazy references. See detail::resolveNode( )
+    bool isRef = false;
+    mutable CompiledSchema const * resolved = nullptr; // owned by CompiledSchema::references
+
+    // the value of a new instance of this node, created the first
+    // time it is needed. See detail::defaultInstance( )
+    mutable std::shared_ptr<json const> defaultValue;
+
+    /**
+     * @brief getMinimum
+     * @return
+     *
+     * Returns the minimum as the requested type, if no minimum
+     * was given, returns the lowest value for that type.
+     */
+    template<typename T>
+    T getMinimum() const
+    {
+        if(!hasMinimum)
+            return std::numeric_limits<T>::lowest();
+        if constexpr (std::is_integral_v<T>)
+            return static_cast<T>(iminimum);
+        else
+            return static_cast<T>(minimum);
+    }
+
+    template<typename T>
+    T getMaximum() const
+    {
+        if(!hasMaximum)
+            return std::numeric_limits<T>::max();
+        if constexpr (std::is_integral_v<T>)
+            return static_cast<T>(imaximum);
+        else
+            return static_cast<T>(maximum);
+    }
+
+    template<typename T>
+    T getStep() const
+    {
+        return step < std::numeric_limits<double>::max() ? static_cast<T>(step) : std::numeric_limits<T>::max();
+    }
+
+    template<typename T>
+    T getStepFast() const
+    {
+        return step_fast < std::numeric_limits<double>::max() ? static_cast<T>(step_fast) : std::numeric_limits<T>::max();
+    }
+};
+
+/**
+ * @brief The CompiledProperty struct
+ *
+ * A property of an object node.
+ */
+struct CompiledProperty
+{
+    std::string const * name = nullptr; // key within the "properties" object
+    uint32_t node     = CompiledNode::npos;
+    bool     required = true;
+};
+
+namespace detail
+{
+/**
+ * @brief The CompiledReferences struct
+ *
+ * The document that the references of a lazily compiled
+ * schema point into, the resolvers that cache the
+ * definitions, and the references compiled so far. Shared
+ * by the schema and all the references compiled from it.
+ */
+struct CompiledReferences
+{
+    explicit CompiledReferences(json doc) :
+        document(std::make_shared<json const>(std::move(doc))),
+        schemas(*document, "$ref", true),
+        values(*document, "$ref", false)
+    {
+    }
+    std::shared_ptr<json const> document;
+    JsonRefResolver             schemas; // references to sub-schemas, expanded one level at a time
+    JsonRefResolver             values;  // references used as keyword values, eg: "enum"
+
+    // the compiled references, keyed by the json of the object containing
+    // the "$ref", so every use of the same definition is compiled once
+    std::unordered_map<std::string, std::unique_ptr<CompiledSchema const>> compiled;
+};
+
+/**
+ * @brief _expandValueReferences
+ * @param schema
+ * @param values
+ *
+ * Expands the references that are used as the value of a keyword
+ * (eg: "enum" : {"$ref" : "#/$defs/list"}) but leaves the references
+ * to sub-schemas (properties, items and oneOf) so that they can be
+ * resolved when they are drawn. The definitions in "$defs" and
+ * "definitions" are not modified.
+ */
+inline void _expandValueReferences(json & schema, JsonRefResolver & values)
+{
+    if(!schema.is_object())
+        return;
+    for(auto & [key, value] : schema.items())
+    {
+        if(key == "$ref" || key == "$defs" || key == "definitions")
+            continue;
+        if(key == "properties" && value.is_object())
+        {
+            for(auto & [name, property] : value.items())
+            {
+                (void)name;
+                _expandValueReferences(property, values);
+            }
+        }
+        else if(key == "oneOf" && value.is_array())
+        {
+            for(auto & alt : value)
+                _expandValueReferences(alt, values);
+        }
+        else if(key == "items" && value.is_object())
+        {
+            _expandValueReferences(value, values);
+        }
+        else
+        {
+            values.expandAll(value);
+        }
+    }
+}
+}
+
+/**
+ * @brief The CompiledSchema struct
+ *
+ * A json schema compiled into a flat array of nodes. nodes[0] is
+ * the root of the schema. Use compileSchema() to create one.
+ *
+ * Properties of an object node are stored in the order they should be drawn
+ * (ui:order first, followed by the remaining properties).
+ *
+ * The source schema is shared between copies so the node
+ * pointers remain valid.
+ */
+struct CompiledSchema
+{
+    std::shared_ptr<json const>    source;
+    detail::WidgetRegistry const * widgets = nullptr; // the registry the widget ids belong to
+    std::vector<CompiledNode>      nodes;
+    std::vector<CompiledProperty>  properties;
+    std::vector<uint32_t>          alternatives;
+
+    // set if the references are resolved when they are first drawn. The
+    // schemas compiled from a reference do not own it, they are owned by it
+    std::shared_ptr<detail::CompiledReferences> references;
+
+    // set if this schema was compiled from a reference which
+    // could not be expanded, eg: a circular reference
+    std::string error;
+
+    bool empty() const
+    {
+        return nodes.empty();
+    }
+    CompiledNode const & root() const
+    {
+        return nodes.front();
+    }
+    CompiledNode const & operator[](uint32_t i) const
+    {
+        return nodes[i];
+    }
+};
+
+namespace detail
+{
+
+inline char const * _compiledString(json const & schema, char const * key)
+{
+    auto it = schema.find(key);
+    if(it == schema.end() || !it->is_string())
+        return nullptr;
+    return it->get_ref<std::string const&>().c_str();
+}
+
+inline int64_t _compiledInteger(json const & v)
+{
+    if(v.is_number_integer())
+        return v.get<int64_t>();
+    // keep the double within the range that can be represented by an int64
+    return static_cast<int64_t>(std::clamp(v.get<double>(), -9.2e18, 9.2e18));
+}
+
+inline uint32_t _compileNode(CompiledSchema & C, json const & schema, WidgetRegistry const & widgets)
+{
+    auto index = static_cast<uint32_t>(C.nodes.size());
+    C.nodes.emplace_back();
+
+    CompiledNode N;
+    N.schema = &schema;
+
+    if(!schema.is_object())
+    {
+        C.nodes[index] = N;
+        return index;
+    }
+
+    // the reference is compiled when it is first drawn
+    if(C.references && schema.contains("$ref"))
+    {
+        N.isRef = true;
+        C.nodes[index] = N;
+        return index;
+    }
+
+    auto typeStr   = JValueView(schema, keyword::type);
+    auto widgetStr = JValueView(schema, keyword::ui_widget);
+
+    N.type        = toSchemaType(typeStr);
+    N.title       = _compiledString(schema, "title");
+    N.description = _compiledString(schema, "description");
+    N.help        = _compiledString(schema, "ui:help");
+    N.hidden      = JValue(schema, "ui:hidden", false);
+    N.isEnum      = schema.contains("enum");
+    N.showReset   = JValue(schema, "ui:showReset", false);
+    N.resizable   = JValue(schema, "ui:resizable", false);
+
+    if(widgetStr == "header")
+        N.layout = NodeLayout::Header;
+    else if(widgetStr == "collapsing")
+        N.layout = NodeLayout::Collapsing;
+
+    // all the widgets were interned by compileSchema( ), so compiling
+    // a reference while drawing does not modify the registry
+    N.widget = widgets.findId(typeStr, widgetStr);
+
+    doIfKeyExists("minimum", schema, [&](auto & v)
+    {
+        if(!v.is_number()) return;
+        N.hasMinimum = true;
+        N.minimum    = v.template get<double>();
+        N.iminimum   = _compiledInteger(v);
+    });
+    doIfKeyExists("maximum", schema, [&](auto & v)
+    {
+        if(!v.is_number()) return;
+        N.hasMaximum = true;
+        N.maximum    = v.template get<double>();
+        N.imaximum   = _compiledInteger(v);
+    });
+    N.step      = JValue(schema, "ui:step"     , N.step);
+    N.step_fast = JValue(schema, "ui:step_fast", N.step_fast);
+    N.speed     = JValue(schema, "ui:speed"    , N.speed);
+    N.minItems  = JValue(schema, "minItems"    , N.minItems);
+    N.maxItems  = JValue(schema, "maxItems"    , N.maxItems);
+
+    // Reserve the property slots first so that the
+    // properties of this node are contiguous
+    auto properties_it = schema.find("properties");
+    if(properties_it != schema.end() && properties_it->is_object())
+    {
+        auto & props = *properties_it;
+
+        std::vector<json::const_iterator> ordered;
+        std::unordered_set<std::string const*> _order;
+        doIfKeyExists("ui:order", schema, [&](auto & order)
+        {
+            for(auto & _ord : order)
+            {
+                if(!_ord.is_string())
+                    continue;
+                auto p_it = props.find(_ord.template get_ref<std::string const&>());
+                if(p_it == props.end() || _order.count(&p_it.key()))
+                    continue;
+                _order.insert(&p_it.key());
+                ordered.push_back(p_it);
+            }
+        });
+        for(auto p_it = props.begin(); p_it != props.end(); ++p_it)
+        {
+            if(_order.count(&p_it.key()) == 0)
+                ordered.push_back(p_it);
+        }
+
+        // all properties are required unless the
+        // "required" array is given
+        auto required_it = schema.find("required");
+        bool hasRequired = required_it != schema.end() && required_it->is_array();
+        if(hasRequired)
+        {
+            N.showAddProperty = required_it->size() != props.size();
+        }
+
+        N.firstProperty = static_cast<uint32_t>(C.properties.size());
+        for(auto & p_it : ordered)
+        {
+            // properties without a type are not drawn
+            if(!p_it->is_object())
+                continue;
+            if(!p_it->contains("type") && !(C.references && p_it->contains("$ref")))
+                continue;
+            CompiledProperty P;
+            P.name = &p_it.key();
+            if(hasRequired)
+            {
+                P.required = std::find(required_it->begin(), required_it->end(), p_it.key()) != required_it->end();
+            }
+            C.properties.push_back(P);
+        }
+        N.propertyCount = static_cast<uint32_t>(C.properties.size()) - N.firstProperty;
+
+        for(uint32_t i = 0; i < N.propertyCount; i++)
+        {
+            auto & P = C.properties[N.firstProperty + i];
+            auto n = _compileNode(C, props.at(*P.name), widgets);
+            C.properties[N.firstProperty + i].node = n;
+        }
+    }
+
+    auto oneOf_it = schema.find("oneOf");
+    if(oneOf_it != schema.end() && oneOf_it->is_array())
+    {
+        N.firstAlternative = static_cast<uint32_t>(C.alternatives.size());
+        N.alternativeCount = static_cast<uint32_t>(oneOf_it->size());
+        C.alternatives.resize(C.alternatives.size() + oneOf_it->size());
+        uint32_t i = 0;
+        for(auto & alt : *oneOf_it)
+        {
+            auto n = _compileNode(C, alt, widgets);
+            C.alternatives[N.firstAlternative + i++] = n;
+        }
+    }
+
+    auto items_it = schema.find("items");
+    if(items_it != schema.end() && items_it->is_object())
+    {
+        N.items = _compileNode(C, *items_it, widgets);
+    }
+
+    C.nodes[index] = N;
+    return index;
+}
+
+/**
+ * @brief _collectWidgetNames
+ * @param J
+ * @param types
+ * @param widgets
+ *
+ * Collects every "type" and "ui:widget" string in J.
+ */
+inline void _collectWidgetNames(json const & J, std::unordered_set<std::string_view> & types, std::unordered_set<std::string_view> & widgets)
+{
+    if(J.is_object())
+    {
+        if(auto t = JValueView(J, keyword::type); !t.empty())
+            types.insert(t);
+        if(auto w = JValueView(J, keyword::ui_widget); !w.empty())
+            widgets.insert(w);
+    }
+    if(J.is_structured())
+    {
+        for(auto & v : J)
+            _collectWidgetNames(v, types, widgets);
+    }
+}
+
+/**
+ * @brief _internWidgets
+ * @param document
+ * @param widgets
+ *
+ * Interns every (type, ui:widget) pair that a schema compiled from the
+ * document could contain. A "$ref" may merge the "ui:widget" of one
+ * object with the "type" of another, so every type is interned with
+ * every widget.
+ */
+inline void _internWidgets(json const & document, WidgetRegistry & widgets)
+{
+    std::unordered_set<std::string_view> types;
+    std::unordered_set<std::string_view> names = {std::string_view()};
+    _collectWidgetNames(document, types, names);
+    for(auto t : types)
+    {
+        for(auto w : names)
+            widgets.intern(t, w);
+    }
+}
+
+/**
+ * @brief _compileReference
+ * @param S
+ * @param schema
+ * @return
+ *
+ * Expands the "$ref" of schema and compiles it. If it cannot be
+ * expanded, the returned schema has a single, empty, node and
+ * the reason in CompiledSchema::error.
+ */
+inline std::unique_ptr<CompiledSchema const> _compileReference(CompiledSchema const & S, json const & schema)
+{
+    auto C = std::make_unique<CompiledSchema>();
+    C->widgets = S.widgets;
+    // does not own the references, they own this schema
+    C->references = std::shared_ptr<CompiledReferences>(std::shared_ptr<CompiledReferences>(), S.references.get());
+
+    json R = schema;
+    try
+    {
+        S.references->schemas.expandReference(R);
+        _expandValueReferences(R, S.references->values);
+    }
+    catch(std::exception & e)
+    {
+        C->error = e.what();
+        R = json::object();
+    }
+    C->source = std::make_shared<json const>(std::move(R));
+    _compileNode(*C, *C->source, *C->widgets);
+    return C;
+}
+
+/**
+ * @brief resolveNode
+ * @param S
+ * @param node
+ * @return
+ *
+ * Returns the schema and node index that should be drawn for
+ * S.nodes[node]. If the node is an unresolved reference, the
+ * reference is expanded and compiled into a new CompiledSchema the
+ * first time this is called, or the first time any node with the
+ * same "$ref" object is resolved. The references within it are left
+ * unresolved until they are drawn.
+ *
+ * If the reference cannot be expanded (eg: it is circular), the
+ * returned schema's error is set instead of throwing.
+ *
+ * Resolving is not thread safe, a lazily compiled schema should
+ * only be drawn from one thread at a time. It does not modify the
+ * widget registry, so other schemas can be drawn at the same time.
+ */
+inline std::pair<CompiledSchema const*, uint32_t> resolveNode(CompiledSchema const & S, uint32_t node)
+{
+    auto * s = &S;
+    while(s->nodes[node].isRef)
+    {
+        auto & N = s->nodes[node];
+        if(!N.resolved)
+        {
+            auto & C = s->references->compiled[N.schema->dump()];
+            if(!C)
+                C = _compileReference(*s, *N.schema);
+            N.resolved = C.get();
+        }
+        s    = N.resolved;
+        node = 0;
+    }
+    return {s, node};
+}
+
+/**
+ * @brief defaultInstance
+ * @param S
+ * @param node
+ * @return
+ *
+ * Returns the default value of S.nodes[node] (see ImJSchema::defaultInstance( )).
+ * The value is created the first time it is requested and kept in the
+ * node, so appending items to an array or resetting an object copies
+ * it instead of walking the schema again. References are resolved
+ * first, with the same thread safety as resolveNode( ).
+ */
+inline json const & defaultInstance(CompiledSchema const & S, uint32_t node)
+{
+    auto [RS, rnode] = resolveNode(S, node);
+    auto & N = RS->nodes[rnode];
+    if(!N.defaultValue)
+    {
+        N.defaultValue = std::make_shared<json const>(ImJSchema::defaultInstance(*N.schema));
+    }
+    return *N.defaultValue;
+}
+
+}
+
+/**
+ * @brief compileSchema
+ * @param schema
+ * @param widgets
+ * @return
+ *
+ * Compiles the json schema into a CompiledSchema. The schema is
+ * copied into the CompiledSchema.
+ *
+ * The "type/ui:widget" key of each node is resolved to an id in the
+ * widget registry at this time, so drawing a node is an array lookup.
+ * Widgets registered after the schema was compiled will still be
+ * used. The registry must outlive the CompiledSchema, and is only
+ * modified by this function, never while drawing.
+ *
+ * Any references in the schema should be expanded before compiling
+ * it, unless lazyReferences is true. In that case, each "$ref" is
+ * resolved and compiled the first time it is drawn, so only the
+ * parts of the schema that are opened are ever expanded, and
+ * recursive schemas can be drawn. The values of references that have
+ * not been drawn are not initialized to their defaults.
+ */
+inline CompiledSchema compileSchema(json schema, detail::WidgetRegistry & widgets, bool lazyReferences = false)
+{
+    CompiledSchema C;
+    C.widgets = &widgets;
+    if(lazyReferences)
+    {
+        C.references = std::make_shared<detail::CompiledReferences>(schema);
+        detail::_expandValueReferences(schema, C.references->values);
+    }
+    C.source = std::make_shared<json const>(std::move(schema));
+    detail::_internWidgets(*C.source, widgets);
+    detail::_compileNode(C, *C.source, widgets);
+    return C;
+}
+
+}
+
+#endif
@@ -0,0 +1,358 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the document cache that is used to
+// load the files referenced by "$ref" : "file.json#/path"
+//
+#ifndef IMJSCHEMA_DOCUMENT_CACHE_H
+#define IMJSCHEMA_DOCUMENT_CACHE_H
+
+#include <nlohmann/json.hpp>
+
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// the posix headers are only needed by JsonDocumentCache::loadFile( ),
+// define IMJSCHEMA_NO_MMAP to read the files with std::ifstream instead
+#if !defined(IMJSCHEMA_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define IMJSCHEMA_DOCUMENT_CACHE_MMAP 1
+#endif
+
+namespace ImJSchema
+{
+using json = nlohmann::json;
+
+/**
+ * @brief The JsonDocumentCache class
+ *
+ * Loads and parses json documents, keyed by their uri. Each document
+ * is only loaded and parsed once, and is shared by every schema
+ * that references it.
+ *
+ * By default, the uri is a file path and the file is memory mapped
+ * while it is parsed. Use setLoader( ) to load the documents from
+ * somewhere else (eg: an archive, or embedded resources).
+ *
+ * The cache can be shared between threads. The lock is not held
+ * while a document is loaded, so the loader may load other documents
+ * from the same cache. A document which is being loaded by one thread
+ * is waited for by the others, rather than loaded twice.
+ *
+ * If documents reference each other, eg: a.json needs b.json and
+ * b.json needs a.json, the load( ) which would close the cycle returns
+ * nullptr instead of waiting. This is the case whether the documents
+ * are loaded by one thread or by several.
+ */
+class JsonDocumentCache
+{
+public:
+    // returns false if the document could not be loaded
+    using loader_type = std::function<bool(std::string const & uri, json & document)>;
+
+    JsonDocumentCache() = default;
+    explicit JsonDocumentCache(loader_type loader) : m_loader(std::move(loader))
+    {
+    }
+
+    /**
+     * @brief setLoader
+     * @param loader
+     *
+     * Sets the function that is used to load a document
+     * that is not in the cache.
+     */
+    void setLoader(loader_type loader)
+    {
+        std::lock_guard<std::mutex> L(m_mutex);
+        m_loader = std::move(loader);
+    }
+
+    /**
+     * @brief load
+     * @param uri
+     * @return
+     *
+     * Returns the document at uri, loading it if it is not
+     * in the cache. Returns nullptr if it could not be loaded
+     * or parsed, or if waiting for it would deadlock: the
+     * document is being loaded by this thread, or by a thread
+     * which is (indirectly) waiting for this one.
+     */
+    std::shared_ptr<json const> load(std::string const & uri)
+    {
+        std::unique_lock<std::mutex> L(m_mutex);
+        while(true)
+        {
+            auto it = m_documents.find(uri);
+            if(it == m_documents.end())
+                break;
+            if(!it->second.loading)
+                return it->second.document;
+            if(_waitClosesCycle(it->second.loader))
+                return nullptr;
+
+            m_waiting[std::this_thread::get_id()] = uri;
+            m_loaded.wait(L);
+            m_waiting.erase(std::this_thread::get_id());
+        }
+
+        m_documents[uri] = _Entry{nullptr, true, std::this_thread::get_id()};
+        auto loader = m_loader;
+        L.unlock();
+
+        json document;
+        bool loaded = false;
+        try
+        {
+            loaded = loader ? loader(uri, document) : loadFile(uri, document);
+        }
+        catch(...)
+        {
+            _finishLoading(uri, nullptr, false);
+            throw;
+        }
+
+        std::shared_ptr<json const> doc;
+        if(loaded)
+            doc = std::make_shared<json const>(std::move(document));
+        return _finishLoading(uri, std::move(doc), true);
+    }
+
+    /**
+     * @brief insert
+     * @param uri
+     * @param document
+     *
+     * Adds a document to the cache, replacing any
+     * document that was loaded from the same uri
+     */
+    void insert(std::string const & uri, json document)
+    {
+        {
+            std::lock_guard<std::mutex> L(m_mutex);
+            m_documents[uri] = _Entry{std::make_shared<json const>(std::move(document)), false, {}};
+        }
+        m_loaded.notify_all();
+    }
+
+    /**
+     * @brief clear
+     *
+     * Removes all the documents, except the ones which are
+     * currently being loaded.
+     */
+    void clear()
+    {
+        std::lock_guard<std::mutex> L(m_mutex);
+        for(auto it = m_documents.begin(); it != m_documents.end(); )
+        {
+            if(it->second.loading)
+                ++it;
+            else
+                it = m_documents.erase(it);
+        }
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> L(m_mutex);
+        return m_documents.size();
+    }
+
+    /**
+     * @brief loadFile
+     * @param path
+     * @param document
+     * @return
+     *
+     * The default loader. Memory maps the file and parses it.
+     */
+    static bool loadFile(std::string const & path, json & document)
+    {
+#if defined(IMJSCHEMA_DOCUMENT_CACHE_MMAP)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        struct stat st;
+        if(::fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        auto size = static_cast<size_t>(st.st_size);
+        void * data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(data == MAP_FAILED)
+            return false;
+
+        auto begin = static_cast<char const*>(data);
+        document = json::parse(begin, begin + size, nullptr, false);
+        ::munmap(data, size);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if(!in)
+            return false;
+        document = json::parse(in, nullptr, false);
+#endif
+        return !document.is_discarded();
+    }
+
+    /**
+     * @brief resolveUri
+     * @param base
+     * @param uri
+     * @return
+     *
+     * Returns the uri relative to the document at base, with the
+     * "." and ".." segments removed.
+     *
+     * eg: resolveUri("schemas/scene.json", "../common/material.json")
+     *     returns "common/material.json"
+     */
+    static std::string resolveUri(std::string_view base, std::string_view uri)
+    {
+        std::string joined;
+        bool absolute = (!uri.empty() && uri.front() == '/') || uri.find("://") != std::string_view::npos;
+        if(!absolute)
+        {
+            auto i = base.find_last_of('/');
+            if(i != std::string_view::npos)
+                joined.assign(base.substr(0, i+1));
+        }
+        joined.append(uri);
+
+        // keep the scheme, eg: "http://", as is
+        size_t start = joined.find("://");
+        start = start == std::string::npos ? 0 : start + 3;
+
+        std::vector<std::string_view> segments;
+        std::string_view path(joined);
+        path.remove_prefix(start);
+        bool leadingSlash = !path.empty() && path.front() == '/';
+        while(!path.empty())
+        {
+            auto i = path.find('/');
+            auto segment = path.substr(0, i);
+            path.remove_prefix(i == std::string_view::npos ? path.size() : i+1);
+            if(segment.empty() || segment == ".")
+                continue;
+            if(segment == ".." && !segments.empty() && segments.back() != "..")
+                segments.pop_back();
+            else
+                segments.push_back(segment);
+        }
+
+        std::string result = joined.substr(0, start);
+        if(leadingSlash)
+            result.push_back('/');
+        for(size_t i = 0; i < segments.size(); i++)
+        {
+            if(i != 0)
+                result.push_back('/');
+            result.append(segments[i]);
+        }
+        return result;
+    }
+
+protected:
+    struct _Entry
+    {
+        std::shared_ptr<json const> document;
+        bool                        loading = false;
+        std::thread::id             loader;  // the thread loading the document
+    };
+
+    // returns true if this thread waiting for a document which is
+    // being loaded by the loader thread would deadlock: the loader is
+    // this thread, or is waiting for a document this thread is loading,
+    // either directly or through other waiting threads
+    bool _waitClosesCycle(std::thread::id loader) const
+    {
+        auto self = std::this_thread::get_id();
+        for(size_t i = 0; i <= m_waiting.size(); i++)
+        {
+            if(loader == self)
+                return true;
+            auto w = m_waiting.find(loader);
+            if(w == m_waiting.end())
+                return false;
+            auto d = m_documents.find(w->second);
+            if(d == m_documents.end() || !d->second.loading)
+                return false;
+            loader = d->second.loader;
+        }
+        return false;
+    }
+
+    // stores the loaded document, unless it was inserted
+    // while it was being loaded, and wakes up the threads
+    // waiting for it
+    std::shared_ptr<json const> _finishLoading(std::string const & uri, std::shared_ptr<json const> doc, bool keep)
+    {
+        {
+            std::lock_guard<std::mutex> L(m_mutex);
+            auto it = m_documents.find(uri);
+            if(it != m_documents.end() && !it->second.loading)
+            {
+                doc = it->second.document;
+            }
+            else if(keep)
+            {
+                m_documents[uri] = _Entry{doc, false, {}};
+            }
+            else if(it != m_documents.end())
+            {
+                m_documents.erase(it);
+            }
+        }
+        m_loaded.notify_all();
+        return doc;
+    }
+
+    mutable std::mutex                     m_mutex;
+    std::condition_variable                m_loaded;
+    loader_type                            m_loader;
+    std::map<std::string, _Entry>          m_documents;
+    std::map<std::thread::id, std::string> m_waiting;   // the document each waiting thread is waiting for
+};
+
+}
+
+#undef IMJSCHEMA_DOCUMENT_CACHE_MMAP
+
+#endif
@@ -26,7 +26,20 @@
 #define IMJSCHEMA_JSON_UTILS_H
 
 #include <nlohmann/json.hpp>
+#include "document_cache.h"
+#include "numeric_array.h"
+
+#include <algorithm>
+#include <atomic>
 #include <charconv>
+#include <exception>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace ImJSchema
 {
@@ -70,27 +83,230 @@ Copies the values from defs which are not in the original object
 inline void jsonExpandAllReferences(json & J, json const & defs, std::string ref= "$ref");
 inline void jsonExpandAllReferences(json & J, std::string ref= "$ref");
 
+/**
+ * @brief The JsonRefStats struct
+ *
+ * Statistics about the references that were expanded by
+ * jsonExpandAllReferences( )
+ */
+struct JsonRefStats
+{
+    size_t references  = 0;   // number of $ref properties that were expanded
+    size_t definitions = 0;   // number of unique definitions that were resolved
+    size_t cacheHits   = 0;   // number of times an already resolved
+                              //    definition was reused
+};
+
+/**
+ * @brief jsonExpandAllReferences
+ * @param J
+ * @param defs
+ * @param stats
+ * @param ref
+ *
+ * Same as jsonExpandAllReferences(J, defs, ref), but also
+ * returns statistics about the expansion
+ */
+inline void jsonExpandAllReferences(json & J, json const & defs, JsonRefStats & stats, std::string ref= "$ref");
+
+/**
+ * @brief jsonExpandAllReferencesParallel
+ * @param J
+ * @param defs
+ * @param threadCount
+ * @param ref
+ *
+ * Same as jsonExpandAllReferences(J, defs, ref), but the independent
+ * subtrees of J are expanded on threadCount threads. If threadCount
+ * is 0, std::thread::hardware_concurrency() threads are used.
+ *
+ * The result is identical to the serial version. defs is only read
+ * during the expansion. If defs is J, a copy of J is used as the defs,
+ * otherwise defs must not be part of J.
+ */
+inline void jsonExpandAllReferencesParallel(json & J, json const & defs, size_t threadCount = 0, std::string ref= "$ref");
+inline void jsonExpandAllReferencesParallel(json & J, size_t threadCount = 0, std::string ref= "$ref");
+
+/**
+ * @brief jsonExpandAllReferences
+ * @param J
+ * @param documents
+ * @param baseUri
+ * @param ref
+ *
+ * Same as jsonExpandAllReferences(J, ref), but references to other
+ * documents, eg: "common/material.json#/$defs/color", are loaded
+ * through the document cache. baseUri is the uri of J, relative
+ * references are resolved from its directory. References within
+ * the other documents are resolved relative to that document.
+ */
+inline void jsonExpandAllReferences(json & J, JsonDocumentCache & documents, std::string baseUri = {}, std::string ref= "$ref");
+
+/**
+ * @brief The CompiledPath class
+ *
+ * A json pointer (RFC 6901) that has been split into its reference
+ * tokens. "~1" and "~0" are unescaped and the tokens that are array
+ * indices are parsed once, so the path can be used for many lookups
+ * without parsing it again.
+ *
+ * Both "/objName/array/0" and the relative form, "objName/array/0",
+ * are accepted. A leading '#' (the URI fragment of a $ref) is ignored.
+ */
+class CompiledPath
+{
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    struct Segment
+    {
+        std::string key;
+        size_t      index = npos; // the array index, or npos if key is not an index
+    };
+
+    CompiledPath() = default;
+    explicit CompiledPath(std::string_view path)
+    {
+        if(!path.empty() && path.front() == '#')
+            path.remove_prefix(1);
+        if(path.empty())
+            return;
+        if(path.front() == '/')
+            path.remove_prefix(1);
+
+        while(true)
+        {
+            auto i = path.find('/');
+            auto token = path.substr(0, i);
+            m_segments.push_back( {unescape(token), parseIndex(token)} );
+            if(i == std::string_view::npos)
+                break;
+            path.remove_prefix(i+1);
+        }
+    }
+
+    auto begin() const { return m_segments.begin(); }
+    auto end()   const { return m_segments.end(); }
+    size_t size() const { return m_segments.size(); }
+    bool empty()  const { return m_segments.empty(); }
+    Segment const & operator[](size_t i) const { return m_segments[i]; }
+
+    /**
+     * @brief unescape
+     * @param token
+     * @return
+     *
+     * Replaces "~1" with "/" and "~0" with "~"
+     */
+    static std::string unescape(std::string_view token)
+    {
+        std::string key;
+        key.reserve(token.size());
+        for(size_t i = 0; i < token.size(); i++)
+        {
+            if(token[i] == '~' && i+1 < token.size() && (token[i+1] == '0' || token[i+1] == '1'))
+            {
+                key.push_back(token[++i] == '0' ? '~' : '/');
+            }
+            else
+            {
+                key.push_back(token[i]);
+            }
+        }
+        return key;
+    }
+
+    /**
+     * @brief parseIndex
+     * @param token
+     * @return
+     *
+     * Returns the array index of the token, or npos if the
+     * token is not a valid array index (digits only, no leading zeros)
+     */
+    static size_t parseIndex(std::string_view token)
+    {
+        if(token.empty() || (token.size() > 1 && token.front() == '0'))
+            return npos;
+        size_t index = npos;
+        auto result = std::from_chars(token.data(), token.data() + token.size(), index);
+        if(result.ec != std::errc() || result.ptr != token.data() + token.size())
+            return npos;
+        return index;
+    }
+
+protected:
+    std::vector<Segment> m_segments;
+};
+
 /**
  * @brief jsonFindPath
  * @param path
  * @param obj
  * @return
  *
- * Returns a pointer to a json object that exists in obj based on its path.
+ * Returns a pointer to a json object that exists in obj based on its path,
+ * or nullptr if it does not exist.
  *
  * eg:
- * a path looks like: "objName/array/0"
+ * a path looks like: "objName/array/0" or "/objName/array/0"
  *
  * {
  *    "objName" : {
  *        "array" : ["first" , "second" ]
  *    }
  * }
+ *
+ * If the same path is looked up many times, use a CompiledPath
+ * or a JsonPathCache.
  */
 inline json * jsonFindPath(std::string_view const path, json & obj);
 inline json const* jsonFindPath(std::string_view const path, json const & obj);
+inline json * jsonFindPath(CompiledPath const & path, json & obj);
+inline json const* jsonFindPath(CompiledPath const & path, json const & obj);
 
 
+/**
+ * The keywords of the JSON Schema and ui: vocabulary used by ImJSchema.
+ *
+ * Keys are looked up as string_views, so none of the functions
+ * below need to construct a std::string to find a keyword.
+ *
+ *  auto type = JValueView(schema, keyword::type);
+ */
+namespace keyword
+{
+inline constexpr std::string_view type        = "type";
+inline constexpr std::string_view properties  = "properties";
+inline constexpr std::string_view items       = "items";
+inline constexpr std::string_view required    = "required";
+inline constexpr std::string_view enum_       = "enum";
+inline constexpr std::string_view enumNames   = "enumNames";
+inline constexpr std::string_view default_    = "default";
+inline constexpr std::string_view title       = "title";
+inline constexpr std::string_view description = "description";
+inline constexpr std::string_view minimum     = "minimum";
+inline constexpr std::string_view maximum     = "maximum";
+inline constexpr std::string_view minItems    = "minItems";
+inline constexpr std::string_view maxItems    = "maxItems";
+inline constexpr std::string_view oneOf       = "oneOf";
+inline constexpr std::string_view ref         = "$ref";
+inline constexpr std::string_view defs        = "$defs";
+
+inline constexpr std::string_view ui_widget    = "ui:widget";
+inline constexpr std::string_view ui_order     = "ui:order";
+inline constexpr std::string_view ui_hidden    = "ui:hidden";
+inline constexpr std::string_view ui_help      = "ui:help";
+inline constexpr std::string_view ui_options   = "ui:options";
+inline constexpr std::string_view ui_step      = "ui:step";
+inline constexpr std::string_view ui_step_fast = "ui:step_fast";
+inline constexpr std::string_view ui_speed     = "ui:speed";
+inline constexpr std::string_view ui_showReset = "ui:showReset";
+inline constexpr std::string_view ui_resizable = "ui:resizable";
+inline constexpr std::string_view ui_addPropertyButtonLabel = "ui:addPropertyButtonLabel";
+inline constexpr std::string_view ui_resetButtonLabel       = "ui:resetButtonLabel";
+}
+
 /**
  * @brief doIfKeyExists
  * @param K
@@ -100,7 +316,7 @@ inline json const* jsonFindPath(std::string_view const path, json const & obj);
  * Executes the callable if a key, K, exists in J
  */
 template<typename jsonObject, typename Callable_type>
-bool doIfKeyExists(json::object_t::key_type const &K, jsonObject & J, Callable_type && C)
+bool doIfKeyExists(std::string_view K, jsonObject & J, Callable_type && C)
 {
     auto it = J.find(K);
     if(it == J.end())
@@ -157,7 +373,7 @@ ValueType _JValue( json const *it, const ValueType& default_value)
  * returns the default value
  */
 template<typename ValueType>
-ValueType JValue(json const & J, json::object_t::key_type const & key, const ValueType& default_value)
+ValueType JValue(json const & J, std::string_view key, const ValueType& default_value)
 {
     auto it = J.find(key);
     if(it == J.end())
@@ -166,6 +382,40 @@ ValueType JValue(json const & J, json::object_t::key_type const & key, const Val
     return _JValue<ValueType>( &*it, default_value);
 }
 
+/**
+ * @brief JStringRef
+ * @param J
+ * @param key
+ * @return
+ *
+ * Returns a pointer to the string stored at J[key], or nullptr if
+ * the key does not exist or is not a string. Nothing is copied.
+ */
+inline std::string const * JStringRef(json const & J, std::string_view key)
+{
+    auto it = J.find(key);
+    if(it == J.end() || !it->is_string())
+        return nullptr;
+    return &it->get_ref<std::string const&>();
+}
+
+/**
+ * @brief JValueView
+ * @param J
+ * @param key
+ * @param default_value
+ * @return
+ *
+ * Same as JValue<std::string>, but returns a view of the string
+ * stored in J instead of a copy. The view is valid as long as J is not
+ * modified.
+ */
+inline std::string_view JValueView(json const & J, std::string_view key, std::string_view default_value = {})
+{
+    auto str = JStringRef(J, key);
+    return str ? std::string_view(*str) : default_value;
+}
+
 
 /**
  * @brief JValue
@@ -193,7 +443,9 @@ ValueType JValue(json const & J, json::array_t::size_type index, const ValueType
 
 
 template<typename T>
-inline T * _jsonFindPath(std::string_view const path, T & obj);
+inline T * _jsonFindPath(std::string_view path, T & obj);
+template<typename T>
+inline T * _jsonFindPath(CompiledPath const & path, T & obj);
 
 /**
  * @brief jsonFindPath
@@ -211,100 +463,569 @@ inline json * jsonFindPath(std::string_view const path, json & obj)
 {
     return _jsonFindPath<json>(path, obj);
 }
+inline json const* jsonFindPath(CompiledPath const & path, json const & obj)
+{
+    return _jsonFindPath<json const>(path, obj);
+}
+inline json * jsonFindPath(CompiledPath const & path, json & obj)
+{
+    return _jsonFindPath<json>(path, obj);
+}
 
+/**
+ * @brief The JsonPathCache class
+ *
+ * Caches the result of jsonFindPath( ) for a single document, so
+ * that looking up the same path again (eg: the same $ref in
+ * many places) does not walk the document.
+ *
+ * The pointers are only valid while the document is not modified.
+ * Call clear( ) if it is.
+ */
+class JsonPathCache
+{
+public:
+    explicit JsonPathCache(json const & doc) : m_doc(doc)
+    {
+    }
+
+    json const * find(std::string_view path)
+    {
+        auto it = m_nodes.find(path);
+        if(it != m_nodes.end())
+            return it->second;
+        auto node = jsonFindPath(path, m_doc);
+        m_nodes.emplace(std::string(path), node);
+        return node;
+    }
+
+    void clear()
+    {
+        m_nodes.clear();
+    }
+
+    size_t size() const
+    {
+        return m_nodes.size();
+    }
+
+protected:
+    json const &                                      m_doc;
+    std::map<std::string, json const*, std::less<> > m_nodes;
+};
 
 
-//=============== Private Functions ======================
 
 /**
- * @brief jsonExpandDefs
- * @param J
- * @param defs
- * @param ref
+ * @brief The JsonSchemaIndex class
  *
- * Expands any ref definitions in J.
- * J[ref] can be either a string in the form "#/path/to/object/in/def"
- * or an array of strings in that same form.
+ * An index of the places a $ref can point to within a single
+ * schema document, built with one pass over the document:
  *
- * When this function returns, J[ref] will be erased and J will be
- * the merged value of all references
+ *    "#/$defs/name"         every entry in a "$defs" or "definitions" object
+ *    "#name"                every "$anchor" : "name"
+ *    "item.json"            every "$id" : "item.json", resolved against
+ *                           the $id of the enclosing schema
+ *    "item.json#name"       anchors within a schema with an $id
+ *
+ * find( ) is a hash lookup for any of the above. Other json pointers,
+ * eg: "#/properties/a", fall back to walking the document.
+ *
+ * The pointers are only valid while the document is not modified.
  */
-inline void _jsonExpandReference(json & J, json const & defs, std::string ref = "$ref")
+class JsonSchemaIndex
 {
-    struct _local
+public:
+    JsonSchemaIndex() = default;
+    explicit JsonSchemaIndex(json const & document, std::string const & baseUri = {})
     {
-        static void _findRefsRecursive(ImJSchema::json const& J,
-                                       ImJSchema::json const& defs,
-                                       std::string const & ref,
-                                       std::vector<std::string> & _refs)
+        build(document, baseUri);
+    }
+
+    /**
+     * @brief build
+     * @param document
+     * @param baseUri
+     *
+     * Rebuilds the index for the document. baseUri is
+     * used to resolve relative $ids.
+     */
+    void build(json const & document, std::string const & baseUri = {})
+    {
+        m_entries.clear();
+        m_root = &document;
+        std::vector<Token> pointer;
+        _index(document, baseUri, pointer);
+    }
+
+    /**
+     * @brief find
+     * @param ref
+     * @return
+     *
+     * Returns the node that the reference points to, or nullptr
+     */
+    json const * find(std::string_view ref) const
+    {
+        if(!m_root)
+            return nullptr;
+        auto it = m_entries.find(_key(ref));
+        if(it != m_entries.end())
+            return it->second;
+
+        // not indexed, a json pointer within the document or
+        // within one of the $id schemas
+        auto hash = ref.find('#');
+        if(hash == std::string_view::npos)
+            return jsonFindPath(ref, *m_root);
+
+        json const * base = m_root;
+        if(hash != 0)
         {
-            auto ref_it = J.find(ref);
-            if(ref_it == J.end())
-                return;
+            auto id_it = m_entries.find(_key(ref.substr(0, hash)));
+            if(id_it == m_entries.end())
+                return nullptr;
+            base = id_it->second;
+        }
+        auto fragment = ref.substr(hash+1);
+        if(fragment.empty() || fragment.front() == '/')
+            return jsonFindPath(fragment, *base);
+        return nullptr;
+    }
+
+    bool contains(std::string_view ref) const
+    {
+        return m_entries.count(_key(ref)) != 0;
+    }
+
+    // the document that was indexed
+    json const * document() const
+    {
+        return m_root;
+    }
+
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+    std::unordered_map<std::string, json const*> const & entries() const
+    {
+        return m_entries;
+    }
+
+protected:
+    // std::unordered_map can only be searched with a std::string in
+    // c++17, so the lookups copy the ref into a buffer which is reused,
+    // rather than creating a new string which allocates for long refs
+    static std::string const & _key(std::string_view ref)
+    {
+        thread_local std::string key;
+        key.assign(ref.data(), ref.size());
+        return key;
+    }
 
-            std::vector<std::string> listOfRefs;
-            if(ref_it->is_string())
-                listOfRefs.push_back( ref_it->get<std::string>() );
-            if(ref_it->is_array())
+    // a reference token of the current json pointer, either
+    // an object key or an array index
+    struct Token
+    {
+        std::string const * key = nullptr;
+        size_t              index = 0;
+    };
+
+    /**
+     * Walks the document. The json pointer to the current node is
+     * kept as a stack of tokens, so a string is only created
+     * when an entry is added.
+     */
+    void _index(json const & J, std::string const & base, std::vector<Token> & pointer)
+    {
+        if(J.is_array())
+        {
+            for(size_t i = 0; i < J.size(); i++)
             {
-                for(auto & a : *ref_it)
-                {
-                    if(a.is_string())
-                        listOfRefs.push_back( a.get<std::string>() );
-                }
+                if(!J[i].is_structured())
+                    continue;
+                pointer.push_back({nullptr, i});
+                _index(J[i], base, pointer);
+                pointer.pop_back();
             }
+            return;
+        }
+        if(!J.is_object())
+            return;
 
-            for(auto & path : listOfRefs)
+        // a schema with an $id starts a new resource, the pointers
+        // of its $defs are relative to it
+        std::string const * _base = &base;
+        std::string id;
+        std::vector<Token> idPointer;
+        auto id_it = J.find("$id");
+        if(id_it != J.end() && id_it->is_string())
+        {
+            auto & value = id_it->get_ref<std::string const&>();
+            if(!value.empty() && value.front() == '#')
             {
-                //auto & path = ref_it->get_ref<std::string const&>();
-                std::string_view path_view(path);
-                if(path_view.front() == '#')
-                {
-                    path_view = path_view.substr(1);
-                }
-                if(path_view.front() == '/')
-                {
-                    path_view = path_view.substr(1);
-                }
-                _refs.push_back( std::string(path_view));
-                auto def_it = ImJSchema::jsonFindPath(path_view, defs);
-                if(def_it && def_it->is_object())
+                // old style anchor, "$id" : "#name"
+                m_entries.emplace(base + value, &J);
+            }
+            else
+            {
+                id = JsonDocumentCache::resolveUri(base, std::string_view(value).substr(0, value.find('#')));
+                m_entries.emplace(id, &J);
+                _base = &id;
+                idPointer.swap(pointer);
+            }
+        }
+
+        auto anchor_it = J.find("$anchor");
+        if(anchor_it != J.end() && anchor_it->is_string())
+        {
+            m_entries.emplace(*_base + "#" + anchor_it->get<std::string>(), &J);
+        }
+
+        for(auto it = J.begin(); it != J.end(); ++it)
+        {
+            auto & value = *it;
+            if(!value.is_structured())
+                continue;
+            pointer.push_back({&it.key(), 0});
+            if((it.key() == "$defs" || it.key() == "definitions") && value.is_object())
+            {
+                for(auto d = value.begin(); d != value.end(); ++d)
                 {
-                    _findRefsRecursive(*def_it,defs, ref, _refs);
+                    pointer.push_back({&d.key(), 0});
+                    m_entries.emplace(_pointerString(*_base, pointer), &*d);
+                    pointer.pop_back();
                 }
             }
+            _index(value, *_base, pointer);
+            pointer.pop_back();
         }
-    };
 
-    std::vector<std::string> _refs;
-    _local::_findRefsRecursive(J, defs, ref, _refs);
+        if(_base == &id)
+            pointer.swap(idPointer);
+    }
+
+    static std::string _pointerString(std::string const & base, std::vector<Token> const & pointer)
+    {
+        std::string str = base;
+        str.push_back('#');
+        for(auto & t : pointer)
+        {
+            str.push_back('/');
+            if(!t.key)
+            {
+                str.append(std::to_string(t.index));
+                continue;
+            }
+            for(auto c : *t.key)
+            {
+                if(c == '~')
+                    str.append("~0");
+                else if(c == '/')
+                    str.append("~1");
+                else
+                    str.push_back(c);
+            }
+        }
+        return str;
+    }
+
+    json const *                                  m_root = nullptr;
+    std::unordered_map<std::string, json const*> m_entries;
+};
+
+//=============== Private Functions ======================
+
+/**
+ * @brief The JsonRefResolver class
+ *
+ * Expands the references in a json object. A reference is a
+ * string in the form "#/path/to/object/in/defs", or an array of
+ * them.
+ *
+ * Each definition is resolved only once: its own references and
+ * all the references within it are expanded, and the result is cached
+ * so that every other object that references it can be merged
+ * with the cached value.
+ *
+ * A definition that references itself (directly, or through
+ * one of its properties) can not be expanded and throws
+ * a std::runtime_error.
+ *
+ * If shallow is true, only the references of the definition itself
+ * are expanded, the references within its properties are left in
+ * place. This is used to resolve references on demand, in which case
+ * a definition may contain itself.
+ *
+ * References to other documents, "file.json#/path", are only
+ * resolved if a document cache is given with setDocuments( ). They
+ * are not supported in shallow mode, because the references left in
+ * the definition would be relative to the other document.
+ */
+class JsonRefResolver
+{
+public:
+    JsonRefResolver(json const & defs, std::string ref = "$ref", bool shallow = false) : m_defs(defs), m_ref(std::move(ref)), m_shallow(shallow)
+    {
+    }
+
+    /**
+     * @brief setDocuments
+     * @param documents
+     * @param baseUri
+     *
+     * Load the references to other documents through the cache.
+     * baseUri is the uri of the defs document.
+     */
+    void setDocuments(JsonDocumentCache & documents, std::string baseUri = {})
+    {
+        m_documents = &documents;
+        m_root.uri  = std::move(baseUri);
+    }
 
+    /**
+     * @brief expandAll
+     * @param J
+     *
+     * Expands all the references in J
+     */
+    void expandAll(json & J)
     {
+        if(J.is_array())
+        {
+            for(auto & i : J)
+            {
+                expandAll(i);
+            }
+        }
+        else if(J.is_object())
+        {
+            expandReference(J);
+            if(!J.is_object())
+                return;
+            for(auto & [key, value] : J.items())
+            {
+                (void)key;
+                expandAll(value);
+            }
+        }
+    }
+
+    /**
+     * @brief expandReference
+     * @param J
+     *
+     * Expands the references of J, but not of its properties.
+     *
+     * When this function returns, J[ref] will be erased and J will be
+     * the merged value of all references. The properties in J take
+     * priority over the properties in the references, and earlier
+     * references take priority over later ones.
+     */
+    void expandReference(json & J)
+    {
+        auto ref_it = J.find(m_ref);
+        if(ref_it == J.end())
+            return;
+
+        std::vector<std::string> paths;
+        if(ref_it->is_string())
+        {
+            paths.push_back( ref_it->get<std::string>() );
+        }
+        else if(ref_it->is_array())
+        {
+            for(auto & a : *ref_it)
+            {
+                if(a.is_string())
+                    paths.push_back( a.get<std::string>() );
+            }
+        }
+        m_stats.references++;
+
         json final;
         // merge everything
-        // for all _refs to be merged, they all have to be objects.
-        while(_refs.size())
+        // for all refs to be merged, they all have to be objects.
+        for(auto it = paths.rbegin(); it != paths.rend(); ++it)
         {
-            auto p = jsonFindPath(_refs.back(), defs);
-            if(p)
+            auto R = resolve(*it);
+            if(!R)
+                continue;
+            if(!R->is_object())
             {
-                if(p && p->is_object())
-                {
-                    final.merge_patch(*p);
-                }
-                else
-                {
-                    final = *p;
-                    J = final;
-                    return;
-                }
+                J = *R;
+                return;
             }
-            _refs.pop_back();
+            final.merge_patch(*R);
         }
+        J.erase(ref_it);
         final.merge_patch(J);
-        final.erase("$ref");
-        J = final;
+        J = std::move(final);
     }
+
+    /**
+     * @brief resolve
+     * @param path
+     * @return
+     *
+     * Returns the expanded definition at path, or nullptr
+     * if it does not exist in the defs.
+     *
+     * The path is either a path within the document that is currently
+     * being expanded, "#/path", or within another document,
+     * "file.json#/path"
+     */
+    json const * resolve(std::string_view path)
+    {
+        auto & scope = m_scopes.empty() ? m_root : m_scopes.back();
+        Scope next = scope;
+        auto & index = _index(scope.document ? *scope.document : m_defs);
+
+        // the definitions of each document are cached
+        // separately: "uri#/path", "uri#anchor"
+        std::string key;
+        std::string fragment;
+
+        auto hash = path.find('#');
+        if(hash != 0 && !path.empty() && index.contains(path.substr(0, hash)))
+        {
+            // an $id within the current document
+            key.assign(scope.uri).append("#").append(path);
+            fragment.assign(path);
+        }
+        else
+        {
+            bool hasHash = hash != std::string_view::npos;
+            if(m_documents && hash != 0 && !path.empty())
+            {
+                next.uri = JsonDocumentCache::resolveUri(scope.uri, path.substr(0, hash));
+                path = hasHash ? path.substr(hash+1) : std::string_view();
+            }
+            else if(hash == 0)
+            {
+                path = path.substr(1);
+            }
+
+            bool anchor = hasHash && !path.empty() && path.front() != '/';
+            if(!path.empty() && path.front() == '/')
+                path = path.substr(1);
+
+            fragment.assign(anchor ? "#" : "#/").append(path);
+            key.assign(next.uri).append(fragment);
+        }
+
+        auto it = m_resolved.find(key);
+        if(it != m_resolved.end())
+        {
+            m_stats.cacheHits++;
+            return &it->second;
+        }
+
+        for(auto & p : m_stack)
+        {
+            if(p == key)
+            {
+                std::string msg = "Circular reference: ";
+                for(auto & s : m_stack)
+                    msg += s + " -> ";
+                msg += key;
+                throw std::runtime_error(msg);
+            }
+        }
+
+        json const * def = nullptr;
+        if(next.uri == scope.uri)
+        {
+            def = index.find(fragment);
+        }
+        else
+        {
+            next.document = m_documents->load(next.uri);
+            if(next.document)
+                def = _index(*next.document).find(fragment);
+        }
+        if(!def)
+            return nullptr;
+
+        json R = *def;
+        m_stack.push_back(key);
+        m_scopes.push_back(std::move(next));
+        try
+        {
+            if(m_shallow)
+                expandReference(R);
+            else
+                expandAll(R);
+        }
+        catch(...)
+        {
+            // the resolver can still be used, eg: to resolve
+            // the other references of a lazily compiled schema
+            m_scopes.pop_back();
+            m_stack.pop_back();
+            throw;
+        }
+        m_scopes.pop_back();
+        m_stack.pop_back();
+
+        m_stats.definitions++;
+        return &m_resolved.emplace(std::move(key), std::move(R)).first->second;
+    }
+
+    JsonRefStats const & stats() const
+    {
+        return m_stats;
+    }
+
+protected:
+    struct Scope
+    {
+        std::string                 uri;
+        std::shared_ptr<json const> document; // nullptr for the defs
+    };
+
+    /**
+     * Returns the index of the document, it is built the
+     * first time a reference into the document is resolved.
+     */
+    JsonSchemaIndex & _index(json const & document)
+    {
+        auto & index = m_indices[&document];
+        if(!index.document())
+            index.build(document);
+        return index;
+    }
+
+    json const &                              m_defs;
+    std::string                               m_ref;
+    bool                                      m_shallow = false;
+    std::map<std::string, json, std::less<> > m_resolved;
+    std::vector<std::string>                  m_stack;   // definitions currently being resolved
+    JsonRefStats                              m_stats;
+    JsonDocumentCache *                       m_documents = nullptr;
+    Scope                                     m_root;    // the defs document
+    std::vector<Scope>                        m_scopes;  // the documents currently being expanded
+    std::map<json const*, JsonSchemaIndex>    m_indices;
+};
+
+/**
+ * @brief jsonExpandDefs
+ * @param J
+ * @param defs
+ * @param ref
+ *
+ * Expands any ref definitions in J.
+ * J[ref] can be either a string in the form "#/path/to/object/in/def"
+ * or an array of strings in that same form.
+ *
+ * When this function returns, J[ref] will be erased and J will be
+ * the merged value of all references
+ */
+inline void _jsonExpandReference(json & J, json const & defs, std::string ref = "$ref")
+{
+    JsonRefResolver(defs, std::move(ref)).expandReference(J);
 }
 
 
@@ -315,29 +1036,130 @@ inline void _jsonExpandReference(json & J, json const & defs, std::string ref =
  * @param ref
  *
  * Recursive fuction which expands ALL definitions
+ *
+ * defs is indexed the first time a reference is resolved, so it
+ * must not be modified while J is expanded. If defs is J, a copy of
+ * J is used as the defs, otherwise defs must not be part of J.
  */
 inline void jsonExpandAllReferences(json & J, json const & defs, std::string ref)
 {
-    if(J.is_array())
+    JsonRefStats stats;
+    jsonExpandAllReferences(J, defs, stats, std::move(ref));
+}
+
+inline void jsonExpandAllReferences(json & J, json const & defs, JsonRefStats & stats, std::string ref)
+{
+    if(&defs == &J)
     {
-        for(auto & i : J)
+        json const copy = J;
+        jsonExpandAllReferences(J, copy, stats, std::move(ref));
+        return;
+    }
+    JsonRefResolver resolver(defs, std::move(ref));
+    resolver.expandAll(J);
+    stats = resolver.stats();
+}
+
+inline void jsonExpandAllReferences(json & J, std::string ref)
+{
+    jsonExpandAllReferences(J, J, ref);
+}
+
+inline void jsonExpandAllReferencesParallel(json & J, json const & defs, size_t threadCount, std::string ref)
+{
+    if(threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // J is modified while it is expanded, so it can
+    // not be read by the other threads
+    json defsCopy;
+    json const * _defs = &defs;
+    if(&defs == &J)
+    {
+        defsCopy = J;
+        _defs = &defsCopy;
+    }
+
+    // Expand the references of the top levels on this thread until
+    // there are enough independent subtrees to split between
+    // the threads. A parent's references must be expanded before
+    // its children are, because the merge replaces the children.
+    JsonRefResolver resolver(*_defs, ref);
+    std::vector<json*> tasks{&J};
+    size_t const taskCount = threadCount * 16;
+    while(threadCount > 1 && !tasks.empty() && tasks.size() < taskCount)
+    {
+        std::vector<json*> next;
+        for(auto * t : tasks)
         {
-            jsonExpandAllReferences(i, defs, ref);
+            if(t->is_object())
+            {
+                resolver.expandReference(*t);
+                if(!t->is_object())
+                    continue;
+            }
+            else if(!t->is_array())
+            {
+                continue;
+            }
+            for(auto & child : *t)
+                next.push_back(&child);
         }
+        tasks = std::move(next);
     }
-    if(J.is_object())
+
+    threadCount = std::min(threadCount, tasks.size());
+    if(threadCount <= 1)
+    {
+        for(auto * t : tasks)
+            resolver.expandAll(*t);
+        return;
+    }
+
+    // each thread has its own resolver, so the definitions
+    // are resolved once per thread
+    std::atomic<size_t> nextTask{0};
+    std::vector<std::exception_ptr> errors(threadCount);
+    auto _worker = [&](size_t w)
     {
-        _jsonExpandReference(J, defs, ref);
-        for(auto [key, value] : J.items())
+        JsonRefResolver threadResolver(*_defs, ref);
+        try
         {
-            jsonExpandAllReferences(value, defs, ref);
+            for(size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+                threadResolver.expandAll(*tasks[i]);
         }
+        catch(...)
+        {
+            errors[w] = std::current_exception();
+            nextTask = tasks.size();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(size_t w = 1; w < threadCount; w++)
+        threads.emplace_back(_worker, w);
+    _worker(0);
+    for(auto & t : threads)
+        t.join();
+
+    for(auto & e : errors)
+    {
+        if(e)
+            std::rethrow_exception(e);
     }
 }
 
-inline void jsonExpandAllReferences(json & J, std::string ref)
+inline void jsonExpandAllReferencesParallel(json & J, size_t threadCount, std::string ref)
 {
-    jsonExpandAllReferences(J, J, ref);
+    jsonExpandAllReferencesParallel(J, J, threadCount, ref);
+}
+
+inline void jsonExpandAllReferences(json & J, JsonDocumentCache & documents, std::string baseUri, std::string ref)
+{
+    json const defs = J;
+    JsonRefResolver resolver(defs, std::move(ref));
+    resolver.setDocuments(documents, std::move(baseUri));
+    resolver.expandAll(J);
 }
 
 
@@ -345,97 +1167,172 @@ inline void jsonExpandAllReferences(json & J, std::string ref)
 
 
 template<typename T>
-inline T * _jsonFindPath(std::string_view const path, T & obj)
+inline T * _jsonFindChild(T & obj, std::string_view key, size_t index)
+{
+    if(obj.is_object())
+    {
+        auto it = obj.find(key);
+        return it != obj.end() ? &(*it) : nullptr;
+    }
+    if(obj.is_array() && index < obj.size())
+    {
+        return &obj[index];
+    }
+    return nullptr;
+}
+
+template<typename T>
+inline T * _jsonFindPath(std::string_view path, T & obj)
 {
     // path == "grandParent/parent/child"
+    if(!path.empty() && path.front() == '#')
+        path.remove_prefix(1);
     if(path.empty())
-    {
         return &obj;
+    if(path.front() == '/')
+        path.remove_prefix(1);
+
+    T * J = &obj;
+    std::string unescaped;
+    while(J)
+    {
+        auto i = path.find('/');
+        auto token = path.substr(0, i);
+        auto index = CompiledPath::parseIndex(token);
+        if(token.find('~') != std::string_view::npos)
+        {
+            unescaped = CompiledPath::unescape(token);
+            token = unescaped;
+        }
+        J = _jsonFindChild<T>(*J, token, index);
+        if(i == std::string_view::npos)
+            break;
+        path.remove_prefix(i+1);
     }
+    return J;
+}
 
-    auto i = path.find_first_of('/');
-    std::string_view stem;
-    std::string_view leaf;
+template<typename T>
+inline T * _jsonFindPath(CompiledPath const & path, T & obj)
+{
+    T * J = &obj;
+    for(auto & segment : path)
+    {
+        J = _jsonFindChild<T>(*J, segment.key, segment.index);
+        if(!J)
+            return nullptr;
+    }
+    return J;
+}
+
+namespace detail
+{
 
-    if(i != std::string_view::npos)
+/**
+ * @brief _initializeNumbers
+ * @param items
+ * @param itemSchema
+ * @param integer
+ *
+ * Same as calling initializeToDefaults( ) on each item of an array
+ * of numbers/integers, but the item schema is only read once.
+ */
+inline void _initializeNumbers(json::array_t & items, json const & itemSchema, bool integer)
+{
+    json _default = integer ? json(0) : json(0.0f);
+    auto it = itemSchema.find("default");
+    if(it != itemSchema.end() && (integer ? it->is_number_integer() : it->is_number()))
+        _default = *it;
+
+    for(auto & a : items)
     {
-        stem = path.substr(0,i); // "grandParent"
-        leaf = path.substr(i+1,std::string_view::npos);  // "parent/child"
+        if(!(integer ? a.is_number_integer() : a.is_number()))
+            a = _default;
     }
-    else
+}
+
+/**
+ * @brief _member
+ * @param object
+ * @param key
+ * @return
+ *
+ * Same as object[key], but the key is only copied if the
+ * member does not exist yet.
+ */
+inline json & _member(json & object, json::string_t const & key)
+{
+    if(object.is_object())
     {
-        leaf = path;
+        auto it = object.find(key);
+        if(it != object.end())
+            return *it;
     }
+    return object[key];
+}
 
-    if(!stem.empty())
+constexpr size_t _minItemsPerThread = 1024;
+
+/**
+ * @brief _parallelFor
+ * @param count
+ * @param threadCount
+ * @param f
+ *
+ * Calls f(begin, end) on consecutive ranges of [0, count), one range
+ * per thread. Fewer threads are used if there would be less than
+ * _minItemsPerThread items per thread. Exceptions thrown by f are
+ * rethrown on the calling thread after all the threads have finished.
+ */
+template<typename F>
+inline void _parallelFor(size_t count, size_t threadCount, F && f)
+{
+    threadCount = std::min(threadCount, count / _minItemsPerThread);
+    if(threadCount <= 1)
     {
-        if(obj.is_object())
-        {
-            auto it = obj.find(stem);
-            if(it != obj.end())
-            {
-                return _jsonFindPath<T>(leaf, *it);
-            }
-        }
-        else if(obj.is_array())
-        {
-            size_t i3 = {};
-            auto result = std::from_chars(stem.data(), stem.data() + stem.size(), i3);
-            if (result.ec != std::errc::invalid_argument)
-            {
-                if(i3 < obj.size())
-                {
-                    return _jsonFindPath<T>(leaf, obj.at(i3));
-                }
-            }
-        }
-        return nullptr;
+        f(size_t(0), count);
+        return;
     }
-    else
+
+    std::vector<std::exception_ptr> errors(threadCount);
+    auto _worker = [&](size_t w)
     {
-        if(obj.is_object())
+        try
         {
-            auto it = obj.find(leaf);
-            if( it != obj.end())
-            {
-                return &(*it);
-            }
+            f(count * w / threadCount, count * (w + 1) / threadCount);
         }
-        else if(obj.is_array())
+        catch(...)
         {
-            size_t i3 = {};
-            auto result = std::from_chars(leaf.data(), leaf.data() + leaf.size(), i3);
-            if (result.ec != std::errc::invalid_argument)
-            {
-                if(i3 < obj.size())
-                {
-                    return &obj.at(i3);
-                }
-            }
+            errors[w] = std::current_exception();
         }
-        return nullptr;
+    };
+
+    std::vector<std::thread> threads;
+    for(size_t w = 1; w < threadCount; w++)
+        threads.emplace_back(_worker, w);
+    _worker(0);
+    for(auto & t : threads)
+        t.join();
+
+    for(auto & e : errors)
+    {
+        if(e)
+            std::rethrow_exception(e);
     }
 }
 
 /**
- * @brief initialize
+ * @brief _initializeToDefaults
  * @param value
  * @param schema
+ * @param threadCount
  *
- * Initialize a json value according to the json schema
- *
- * For boolean, number, integer, string, if
- * the "default" value defined,
- * the value will be set to the default. If it is not
- * it will be initialized to zero.
- *
- * For arrays and objects, if the "default" value is defined,
- * it will be set to that value. If not, it will recurively go
- * through each of the child properties and call initialize on it
+ * The implementation of initializeToDefaults( ). The items of
+ * large arrays are initialized on threadCount threads.
  */
-inline void initializeToDefaults(json & value, json const & schema)
+inline void _initializeToDefaults(json & value, json const & schema, size_t threadCount)
 {
-    auto type = JValue(schema, "type", std::string());
+    auto type = JValueView(schema, keyword::type);
     if(type == "object")
     {
         // a default value for the object was
@@ -464,14 +1361,15 @@ inline void initializeToDefaults(json & value, json const & schema)
             // optional
             for(auto & propertyName : *required_it)
             {
-                initializeToDefaults( value[propertyName], properties_it->at(propertyName));
+                auto & name = propertyName.get_ref<json::string_t const&>();
+                _initializeToDefaults( _member(value, name), properties_it->at(name), threadCount);
             }
         }
         else
         {
             for(auto & [propertyName, propertySchema] : properties_it->items())
             {
-                initializeToDefaults( value[propertyName], propertySchema);
+                _initializeToDefaults( _member(value, propertyName), propertySchema, threadCount);
             }
         }
 
@@ -500,12 +1398,54 @@ inline void initializeToDefaults(json & value, json const & schema)
         auto maxItems = JValue(schema, "maxItems", std::numeric_limits<size_t>::max());
 
         auto & _arr = value.get_ref<json::array_t&>();
-        _arr.resize( std::clamp(value.size(), minItems, maxItems));
+        auto oldSize = _arr.size();
+        auto newSize = std::clamp(oldSize, minItems, maxItems);
 
         auto it = schema.find("items");
-        for(auto & a : _arr)
+        if(it == schema.end())
         {
-            initializeToDefaults(a, *it);
+            _arr.resize(newSize);
+            return;
+        }
+
+        // arrays of numbers are common (curves, lookup tables), so
+        // read the item schema once instead of once per item
+        auto itemType = JValueView(*it, keyword::type);
+        if(itemType == "number" || itemType == "integer")
+        {
+            _arr.resize(newSize);
+            detail::_initializeNumbers(_arr, *it, itemType == "integer");
+            return;
+        }
+
+        if(newSize < oldSize)
+            _arr.resize(newSize);
+        _parallelFor(_arr.size(), threadCount, [&](size_t b, size_t e)
+        {
+            for(size_t i = b; i < e; i++)
+                _initializeToDefaults(_arr[i], *it, 1);
+        });
+
+        // the new items are all the same, so build one
+        // and copy it instead of initializing each one
+        if(newSize > oldSize)
+        {
+            json _item;
+            _initializeToDefaults(_item, *it, threadCount);
+
+            // copying an object/array/string allocates, so those
+            // are copied on multiple threads
+            if(threadCount <= 1 || !(_item.is_structured() || _item.is_string()))
+            {
+                _arr.insert(_arr.end(), newSize - oldSize, _item);
+                return;
+            }
+            _arr.resize(newSize);
+            _parallelFor(newSize - oldSize, threadCount, [&](size_t b, size_t e)
+            {
+                for(size_t i = b; i < e; i++)
+                    _arr[oldSize + i] = _item;
+            });
         }
     }
     else if(type == "boolean")
@@ -564,6 +1504,62 @@ inline void initializeToDefaults(json & value, json const & schema)
 
 }
 
+/**
+ * @brief initialize
+ * @param value
+ * @param schema
+ *
+ * Initialize a json value according to the json schema
+ *
+ * For boolean, number, integer, string, if
+ * the "default" value defined,
+ * the value will be set to the default. If it is not
+ * it will be initialized to zero.
+ *
+ * For arrays and objects, if the "default" value is defined,
+ * it will be set to that value. If not, it will recurively go
+ * through each of the child properties and call initialize on it
+ */
+inline void initializeToDefaults(json & value, json const & schema)
+{
+    detail::_initializeToDefaults(value, schema, 1);
+}
+
+/**
+ * @brief initializeToDefaultsParallel
+ * @param value
+ * @param schema
+ * @param threadCount
+ *
+ * Same as initializeToDefaults( ), but arrays with a large number of
+ * items (eg: a "minItems" of 100000) are filled on threadCount threads.
+ * If threadCount is 0, std::thread::hardware_concurrency() threads are
+ * used. The result is identical to initializeToDefaults( ).
+ */
+inline void initializeToDefaultsParallel(json & value, json const & schema, size_t threadCount = 0)
+{
+    if(threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    detail::_initializeToDefaults(value, schema, threadCount);
+}
+
+/**
+ * @brief defaultInstance
+ * @param schema
+ * @return
+ *
+ * Returns the value initializeToDefaults( ) creates from null, ie: the
+ * value of a new array item or of an object after it has been reset.
+ */
+inline json defaultInstance(json const & schema)
+{
+    json J;
+    initializeToDefaults(J, schema);
+    return J;
+}
+
+}
+
 
 #endif
 
@@ -0,0 +1,270 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the fast path for arrays of numbers, eg: curves
+// and lookup tables. The numbers are copied into a contiguous buffer
+// once, and the bounds are checked/clamped with branch free loops
+// that the compiler can vectorize.
+//
+#ifndef IMJSCHEMA_NUMERIC_ARRAY_H
+#define IMJSCHEMA_NUMERIC_ARRAY_H
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ImJSchema
+{
+using json = nlohmann::json;
+
+/**
+ * @brief The NumericBounds struct
+ *
+ * The bounds of the items of a numeric array. A value x is in range if
+ *
+ *     minimum <= x <= maximum  and  exclusiveMinimum < x < exclusiveMaximum
+ *
+ * The bounds which are not used are infinite.
+ */
+struct NumericBounds
+{
+    double minimum          = -std::numeric_limits<double>::infinity();
+    double maximum          =  std::numeric_limits<double>::infinity();
+    double exclusiveMinimum = -std::numeric_limits<double>::infinity();
+    double exclusiveMaximum =  std::numeric_limits<double>::infinity();
+
+    /**
+     * @brief fromSchema
+     * @param schema
+     * @return
+     *
+     * Reads the minimum/maximum/exclusiveMinimum/exclusiveMaximum
+     * of a number schema
+     */
+    static NumericBounds fromSchema(json const & schema)
+    {
+        NumericBounds B;
+        auto _read = [&](char const * key, double & v)
+        {
+            auto it = schema.find(key);
+            if(it != schema.end() && it->is_number())
+                v = it->get<double>();
+        };
+        _read("minimum",          B.minimum);
+        _read("maximum",          B.maximum);
+        _read("exclusiveMinimum", B.exclusiveMinimum);
+        _read("exclusiveMaximum", B.exclusiveMaximum);
+        return B;
+    }
+
+    bool unbounded() const
+    {
+        return minimum == -std::numeric_limits<double>::infinity() &&
+               maximum ==  std::numeric_limits<double>::infinity() &&
+               exclusiveMinimum == -std::numeric_limits<double>::infinity() &&
+               exclusiveMaximum ==  std::numeric_limits<double>::infinity();
+    }
+};
+
+namespace detail
+{
+
+/**
+ * @brief _extractNumbers
+ * @param array
+ * @param out
+ * @return
+ *
+ * Copies the numbers of a json array into out. Elements that are
+ * not numbers (or are floats, if integersOnly is set) are stored as
+ * NaN, which is never in range. Returns the number of NaNs stored.
+ */
+inline size_t _extractNumbers(json const & array, std::vector<double> & out, bool integersOnly = false)
+{
+    auto & A = array.get_ref<json::array_t const&>();
+    out.resize(A.size());
+    size_t notNumbers = 0;
+    auto p = out.data();
+    for(auto & v : A)
+    {
+        switch(v.type())
+        {
+            case json::value_t::number_float:
+                if(integersOnly)
+                {
+                    *p = std::numeric_limits<double>::quiet_NaN();
+                    notNumbers++;
+                }
+                else
+                {
+                    *p = v.get_ref<json::number_float_t const&>();
+                }
+                break;
+            case json::value_t::number_integer:  *p = static_cast<double>(v.get_ref<json::number_integer_t const&>()); break;
+            case json::value_t::number_unsigned: *p = static_cast<double>(v.get_ref<json::number_unsigned_t const&>()); break;
+            default:
+                *p = std::numeric_limits<double>::quiet_NaN();
+                notNumbers++;
+                break;
+        }
+        ++p;
+    }
+    return notNumbers;
+}
+
+/**
+ * @brief _findOutOfRange
+ * @param p
+ * @param n
+ * @param B
+ * @param out
+ *
+ * Appends the indices of the values which are not in range (or are NaN)
+ * to out. The values are checked in blocks without branches, and only
+ * the blocks that contain a bad value are searched for its index, so
+ * the common case, where every value is valid, is vectorized.
+ */
+inline void _findOutOfRange(double const * p, size_t n, NumericBounds const & B, std::vector<size_t> & out)
+{
+    constexpr size_t block = 32;
+    double const lo = B.minimum, hi = B.maximum, elo = B.exclusiveMinimum, ehi = B.exclusiveMaximum;
+
+    for(size_t i = 0; i < n; i += block)
+    {
+        auto end = std::min(n, i + block);
+        uint32_t bad = 0;
+        for(size_t j = i; j < end; j++)
+        {
+            auto x = p[j];
+            // comparisons with NaN are false, so NaN is never in range
+            bad |= static_cast<uint32_t>(!((x >= lo) & (x <= hi) & (x > elo) & (x < ehi)));
+        }
+        if(!bad)
+            continue;
+        for(size_t j = i; j < end; j++)
+        {
+            auto x = p[j];
+            if(!((x >= lo) & (x <= hi) & (x > elo) & (x < ehi)))
+                out.push_back(j);
+        }
+    }
+}
+
+/**
+ * @brief _clampRange
+ * @param p
+ * @param n
+ * @param lo
+ * @param hi
+ *
+ * Clamps the values to [lo, hi]. NaN values are not modified.
+ */
+inline void _clampRange(double * p, size_t n, double lo, double hi)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        auto x = p[i];
+        x = x < lo ? lo : x;
+        x = x > hi ? hi : x;
+        p[i] = x;
+    }
+}
+
+}
+
+/**
+ * @brief clampNumericArray
+ * @param value
+ * @param itemSchema
+ * @return
+ *
+ * Clamps the numbers of an array to the minimum/maximum of the
+ * item schema. Exclusive bounds are clamped to the nearest
+ * representable value inside the bound. Elements that are not numbers
+ * are not modified, integers stay integers (rounded towards the
+ * range). Returns the number of elements that were changed.
+ */
+inline size_t clampNumericArray(json & value, json const & itemSchema)
+{
+    if(!value.is_array())
+        return 0;
+
+    auto B = NumericBounds::fromSchema(itemSchema);
+    if(B.unbounded())
+        return 0;
+
+    auto lo = std::max(B.minimum, std::nextafter(B.exclusiveMinimum,  std::numeric_limits<double>::infinity()));
+    auto hi = std::min(B.maximum, std::nextafter(B.exclusiveMaximum, -std::numeric_limits<double>::infinity()));
+    if(!(lo <= hi))
+        return 0;
+
+    thread_local std::vector<double> buffer;
+    detail::_extractNumbers(value, buffer);
+    detail::_clampRange(buffer.data(), buffer.size(), lo, hi);
+
+    // only the values that changed are written back
+    size_t changed = 0;
+    auto & A = value.get_ref<json::array_t&>();
+    for(size_t i = 0; i < A.size(); i++)
+    {
+        auto & v = A[i];
+        auto x = buffer[i];
+        switch(v.type())
+        {
+            case json::value_t::number_float:
+                if(v.get_ref<json::number_float_t&>() != x)
+                {
+                    v = x;
+                    changed++;
+                }
+                break;
+            case json::value_t::number_integer:
+            case json::value_t::number_unsigned:
+            {
+                auto original = v.get<double>();
+                if(original != x)
+                {
+                    // round towards the inside of the range
+                    auto r = original < x ? std::ceil(x) : std::floor(x);
+                    v = static_cast<json::number_integer_t>(r);
+                    changed++;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return changed;
+}
+
+}
+
+#endif
@@ -0,0 +1,295 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the WidgetProfiler, which collects the time
+// spent drawing each widget of a form. The draw functions are only
+// instrumented when IMJSCHEMA_PROFILER is defined to 1 before
+// ImJSchema.h is included, otherwise the profiler is never called.
+//
+// The allocations made by each widget are also recorded if they are
+// counted, see allocation_hooks.h.
+//
+#ifndef IMJSCHEMA_PROFILER_H
+#define IMJSCHEMA_PROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "allocation_hooks.h"
+
+#ifndef IMJSCHEMA_PROFILER
+#define IMJSCHEMA_PROFILER 0
+#endif
+
+namespace ImJSchema
+{
+
+/**
+ * @brief The WidgetStats struct
+ *
+ * The number of calls and the time spent in the calls. The inclusive
+ * time includes the widgets drawn within the widget (eg: the properties
+ * of an object), the self time does not. The allocations are the
+ * ones made by the widget itself, not by the widgets drawn within it.
+ */
+struct WidgetStats
+{
+    uint64_t        calls       = 0;
+    uint64_t        inclusiveNs = 0;
+    uint64_t        selfNs      = 0;
+    AllocationStats allocs;
+
+    WidgetStats & operator+=(WidgetStats const & o)
+    {
+        calls       += o.calls;
+        inclusiveNs += o.inclusiveNs;
+        selfNs      += o.selfNs;
+        allocs      += o.allocs;
+        return *this;
+    }
+    WidgetStats & operator-=(WidgetStats const & o)
+    {
+        calls       -= o.calls;
+        inclusiveNs -= o.inclusiveNs;
+        selfNs      -= o.selfNs;
+        allocs      -= o.allocs;
+        return *this;
+    }
+};
+
+/**
+ * @brief The WidgetProfiler class
+ *
+ * Aggregates the WidgetStats of each widget path (the labels from the
+ * root of the form to the widget, eg: "object/points/3/x") and of each
+ * widget key (eg: "number/slider", "array/color"), over the last
+ * frameCount frames.
+ *
+ * Set Context::profiler and call endFrame() once per frame, after the
+ * forms have been drawn:
+ *
+ *  static WidgetProfiler profiler;
+ *  ctx.profiler = &profiler;
+ *  drawSchemaWidget(ctx, compiled, value, state);
+ *  profiler.endFrame();
+ *  drawProfilerWindow(profiler);
+ *
+ * Nothing is recorded unless IMJSCHEMA_PROFILER is 1.
+ */
+class WidgetProfiler
+{
+public:
+    using stats_map = std::map<std::string, WidgetStats, std::less<>>;
+    using clock     = std::chrono::steady_clock;
+
+    explicit WidgetProfiler(size_t frameCount = 120) : m_capacity(std::max<size_t>(frameCount, 1))
+    {
+    }
+
+    /**
+     * @brief endFrame
+     *
+     * Moves the widgets recorded since the last call into the
+     * window of frames, dropping the oldest frame if it is full.
+     */
+    void endFrame()
+    {
+        auto a0 = threadAllocationStats();
+        _add(m_paths,   m_current.paths);
+        _add(m_widgets, m_current.widgets);
+        m_frames.push_back(std::move(m_current));
+        m_current = {};
+
+        if(m_frames.size() > m_capacity)
+        {
+            _subtract(m_paths,   m_frames.front().paths);
+            _subtract(m_widgets, m_frames.front().widgets);
+            m_frames.pop_front();
+        }
+        m_own += threadAllocationStats() - a0;
+    }
+
+    void clear()
+    {
+        m_frames.clear();
+        m_current = {};
+        m_paths.clear();
+        m_widgets.clear();
+    }
+
+    // number of frames the stats were collected over
+    size_t frameCount() const
+    {
+        return m_frames.size();
+    }
+
+    // the stats of every path/widget key over the last frameCount() frames
+    stats_map const & paths() const
+    {
+        return m_paths;
+    }
+    stats_map const & widgets() const
+    {
+        return m_widgets;
+    }
+
+    /**
+     * @brief hottest
+     * @param stats
+     * @param count
+     * @param self
+     * @return
+     *
+     * Returns the count entries with the most inclusive time, or
+     * self time if self is true, sorted from most to least time.
+     */
+    static std::vector<std::pair<std::string_view, WidgetStats>> hottest(stats_map const & stats, size_t count, bool self = false)
+    {
+        std::vector<std::pair<std::string_view, WidgetStats>> out;
+        out.reserve(stats.size());
+        for(auto & [key, s] : stats)
+            out.emplace_back(key, s);
+
+        auto _time = [self](auto const & e) { return self ? e.second.selfNs : e.second.inclusiveNs; };
+        count = std::min(count, out.size());
+        std::partial_sort(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(count), out.end(),
+                          [&](auto const & a, auto const & b) { return _time(a) > _time(b); });
+        out.resize(count);
+        return out;
+    }
+
+    /**
+     * @brief beginWidget
+     * @param label
+     *
+     * Called by the draw functions before a widget is drawn. Each call
+     * must be matched with an endWidget( ) once it has been drawn.
+     */
+    void beginWidget(std::string_view label)
+    {
+        auto a0 = threadAllocationStats();
+        m_stack.push_back({m_path.size(), 0, a0 - m_own, {}, clock::now()});
+        if(m_stack.size() > 1)
+            m_path.push_back('/');
+        m_path.append(label);
+        m_own += threadAllocationStats() - a0;
+    }
+
+    /**
+     * @brief endWidget
+     * @param type
+     * @param widget
+     *
+     * Records the time since the matching beginWidget( ) for the
+     * current path and for the widget key "type/widget".
+     */
+    void endWidget(std::string_view type, std::string_view widget)
+    {
+        if(m_stack.empty())
+            return;
+        auto now = clock::now();
+        auto a0  = threadAllocationStats();
+        auto top = m_stack.back();
+        m_stack.pop_back();
+
+        auto ns     = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - top.start).count());
+        auto allocs = a0 - m_own - top.allocStart;
+        WidgetStats s{1, ns, ns - std::min(ns, top.childNs), allocs - top.childAllocs};
+
+        m_key.assign(type).append("/").append(widget);
+        _find(m_current.paths, m_path) += s;
+        _find(m_current.widgets, m_key) += s;
+
+        if(!m_stack.empty())
+        {
+            m_stack.back().childNs     += ns;
+            m_stack.back().childAllocs += allocs;
+        }
+        m_path.resize(top.pathSize);
+        m_own += threadAllocationStats() - a0;
+    }
+
+protected:
+    struct Frame
+    {
+        stats_map paths;
+        stats_map widgets;
+    };
+    struct Open
+    {
+        size_t            pathSize;
+        uint64_t          childNs;
+        AllocationStats   allocStart;
+        AllocationStats   childAllocs;
+        clock::time_point start;
+    };
+
+    static WidgetStats & _find(stats_map & m, std::string_view key)
+    {
+        auto it = m.find(key);
+        if(it == m.end())
+            it = m.emplace(std::string(key), WidgetStats{}).first;
+        return it->second;
+    }
+    static void _add(stats_map & total, stats_map const & frame)
+    {
+        for(auto & [key, s] : frame)
+            _find(total, key) += s;
+    }
+    static void _subtract(stats_map & total, stats_map const & frame)
+    {
+        for(auto & [key, s] : frame)
+        {
+            auto it = total.find(key);
+            if(it == total.end())
+                continue;
+            it->second -= s;
+            if(it->second.calls == 0)
+                total.erase(it);
+        }
+    }
+
+    size_t            m_capacity;
+    std::deque<Frame> m_frames;
+    Frame             m_current;
+    stats_map         m_paths;
+    stats_map         m_widgets;
+
+    std::vector<Open> m_stack;
+    std::string       m_path;
+    std::string       m_key;
+    AllocationStats   m_own;    // allocations made by the profiler, which are not counted
+};
+
+}
+
+#endif
@@ -0,0 +1,1118 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the matchers for the "pattern" and "format"
+// keywords of string schemas, and the cache that shares them
+//
+#ifndef IMJSCHEMA_STRING_MATCHER_H
+#define IMJSCHEMA_STRING_MATCHER_H
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ImJSchema
+{
+
+/**
+ * @brief The StringMatcher class
+ *
+ * Matches strings against the regular expression of a "pattern"
+ * keyword. Like JSON Schema, the pattern is not anchored, so "a+"
+ * matches "baab". Use ^ and $ to match the entire string.
+ *
+ * The common subset of the ECMAScript syntax (characters, classes,
+ * \d \w \s, groups, alternation, the quantifiers * + ? {n,m} and the
+ * anchors ^ $) is compiled into a DFA, so matching is a single pass
+ * over the string without any backtracking or allocations. Patterns
+ * using anything else (eg: back references, lookaheads, \b) use
+ * std::regex instead.
+ *
+ * The matcher is not modified when matching, so it can be shared
+ * between threads. Use getStringMatcherCache() to share the matchers
+ * of the same pattern.
+ *
+ * Throws std::regex_error if the pattern is not valid.
+ */
+class StringMatcher
+{
+public:
+    explicit StringMatcher(std::string_view pattern) : m_pattern(pattern)
+    {
+        if(!_compile())
+        {
+            m_regex = std::make_unique<std::regex>(m_pattern, std::regex::ECMAScript | std::regex::optimize);
+        }
+    }
+
+    /**
+     * @brief search
+     * @param str
+     * @return
+     *
+     * Returns true if the pattern matches any part of str
+     */
+    bool search(std::string_view str) const
+    {
+        if(m_regex)
+            return std::regex_search(str.begin(), str.end(), *m_regex);
+
+        if(str.empty())
+            return m_matchesEmpty;
+        if(m_table.empty())
+            return _simulate(str);
+
+        uint32_t s = 0;
+        if(m_states[s].accept)
+            return true;
+        for(auto c : str)
+        {
+            s = m_table[s * m_classCount + m_classes[static_cast<unsigned char>(c)]];
+            auto & S = m_states[s];
+            if(S.accept)
+                return true;
+            if(S.dead)
+                return false;
+        }
+        return m_states[s].acceptAtEnd;
+    }
+
+    std::string const & pattern() const
+    {
+        return m_pattern;
+    }
+
+    // true if the pattern is matched using std::regex
+    bool usesRegex() const
+    {
+        return m_regex != nullptr;
+    }
+
+    // number of DFA states, 0 if the DFA was not built
+    size_t stateCount() const
+    {
+        return m_table.empty() ? 0 : m_states.size();
+    }
+
+    static constexpr size_t maxInstructions = 2048;
+    static constexpr size_t maxStates       = 1024;
+
+protected:
+    using CharSet = std::bitset<256>;
+
+    enum class Op : uint8_t
+    {
+        Set,    // consume a character in sets[x]
+        Split,  // continue at x and y
+        Jmp,    // continue at x
+        Bol,    // beginning of the string
+        Eol,    // end of the string
+        Match
+    };
+
+    struct Inst
+    {
+        Op       op = Op::Match;
+        uint32_t x  = 0;
+        uint32_t y  = 0;
+    };
+
+    struct Node
+    {
+        enum Kind : uint8_t { Empty, Set, Concat, Alt, Repeat, Bol, Eol } kind = Empty;
+        uint32_t set = 0;
+        uint32_t min = 0;
+        uint32_t max = 0;               // infinite for x*, x+ and x{n,}
+        std::vector<Node> children;
+    };
+
+    struct State
+    {
+        bool accept      = false;       // a match has been found
+        bool acceptAtEnd = false;       // a match is found if the string ends here
+        bool dead        = false;       // no match can be found
+    };
+
+    static constexpr uint32_t infinite = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * @brief The Parser struct
+     *
+     * Parses the supported subset of the pattern syntax. Returns
+     * false for anything else so std::regex can be used.
+     */
+    struct Parser
+    {
+        std::string_view      str;
+        size_t                i = 0;
+        std::vector<CharSet> & sets;
+
+        bool done() const { return i >= str.size(); }
+        char peek() const { return str[i]; }
+
+        uint32_t addSet(CharSet const & s)
+        {
+            sets.push_back(s);
+            return static_cast<uint32_t>(sets.size() - 1);
+        }
+
+        bool alternation(Node & out)
+        {
+            Node first;
+            if(!concat(first))
+                return false;
+            if(done() || peek() != '|')
+            {
+                out = std::move(first);
+                return true;
+            }
+            out.kind = Node::Alt;
+            out.children.push_back(std::move(first));
+            while(!done() && peek() == '|')
+            {
+                ++i;
+                out.children.emplace_back();
+                if(!concat(out.children.back()))
+                    return false;
+            }
+            return true;
+        }
+
+        bool concat(Node & out)
+        {
+            out.kind = Node::Concat;
+            while(!done() && peek() != '|' && peek() != ')')
+            {
+                out.children.emplace_back();
+                if(!repeat(out.children.back()))
+                    return false;
+            }
+            return true;
+        }
+
+        bool repeat(Node & out)
+        {
+            if(!atom(out))
+                return false;
+            if(!done())
+            {
+                uint32_t min = 0, max = 0;
+                auto c = peek();
+                if(c == '*')      { min = 0; max = infinite; ++i; }
+                else if(c == '+') { min = 1; max = infinite; ++i; }
+                else if(c == '?') { min = 0; max = 1; ++i; }
+                else if(c == '{')
+                {
+                    ++i;
+                    if(!number(min))
+                        return false;
+                    max = min;
+                    if(!done() && peek() == ',')
+                    {
+                        ++i;
+                        max = infinite;
+                        if(!done() && peek() != '}' && !number(max))
+                            return false;
+                    }
+                    if(done() || peek() != '}' || max < min)
+                        return false;
+                    ++i;
+                }
+                else
+                {
+                    return true;
+                }
+                // lazy quantifiers match the same strings
+                if(!done() && peek() == '?')
+                    ++i;
+
+                if(out.kind == Node::Bol || out.kind == Node::Eol)
+                    return false;
+                Node R;
+                R.kind = Node::Repeat;
+                R.min = min;
+                R.max = max;
+                R.children.push_back(std::move(out));
+                out = std::move(R);
+            }
+            return true;
+        }
+
+        bool number(uint32_t & n)
+        {
+            if(done() || peek() < '0' || peek() > '9')
+                return false;
+            n = 0;
+            while(!done() && peek() >= '0' && peek() <= '9')
+            {
+                n = n * 10 + static_cast<uint32_t>(peek() - '0');
+                if(n > maxInstructions)
+                    return false;
+                ++i;
+            }
+            return true;
+        }
+
+        bool atom(Node & out)
+        {
+            auto c = peek();
+            ++i;
+            switch(c)
+            {
+                case '^': out.kind = Node::Bol; return true;
+                case '$': out.kind = Node::Eol; return true;
+                case '.':
+                {
+                    CharSet s;
+                    s.set();
+                    s.reset('\n');
+                    s.reset('\r');
+                    out.kind = Node::Set;
+                    out.set = addSet(s);
+                    return true;
+                }
+                case '(':
+                {
+                    if(!done() && peek() == '?')
+                    {
+                        if(i+1 >= str.size() || str[i+1] != ':')
+                            return false;
+                        i += 2;
+                    }
+                    if(!alternation(out))
+                        return false;
+                    if(done() || peek() != ')')
+                        return false;
+                    ++i;
+                    return true;
+                }
+                case '[':
+                {
+                    CharSet s;
+                    if(!charClass(s))
+                        return false;
+                    out.kind = Node::Set;
+                    out.set = addSet(s);
+                    return true;
+                }
+                case '\\':
+                {
+                    CharSet s;
+                    if(!escape(s, false))
+                        return false;
+                    out.kind = Node::Set;
+                    out.set = addSet(s);
+                    return true;
+                }
+                case ')': case '*': case '+': case '?': case '{': case '}': case ']': case '|':
+                    return false;
+                default:
+                {
+                    CharSet s;
+                    s.set(static_cast<unsigned char>(c));
+                    out.kind = Node::Set;
+                    out.set = addSet(s);
+                    return true;
+                }
+            }
+        }
+
+        // the escape after the '\', adds its characters to s
+        bool escape(CharSet & s, bool inClass)
+        {
+            if(done())
+                return false;
+            auto c = peek();
+            ++i;
+            auto _range = [&](char a, char b) { for(int x = a; x <= b; x++) s.set(static_cast<size_t>(x)); };
+            CharSet cls;
+            switch(c)
+            {
+                case 'd': _range('0','9'); return true;
+                case 'w': _range('0','9'); _range('a','z'); _range('A','Z'); s.set('_'); return true;
+                case 's': for(auto w : {' ', '\t', '\n', '\v', '\f', '\r'}) s.set(static_cast<unsigned char>(w)); return true;
+                case 'D': cls.set(); for(int x = '0'; x <= '9'; x++) cls.reset(static_cast<size_t>(x)); s |= cls; return true;
+                case 'W':
+                {
+                    std::swap(s, cls);
+                    _range('0','9'); _range('a','z'); _range('A','Z'); s.set('_');
+                    s = cls | ~s;
+                    return true;
+                }
+                case 'S':
+                {
+                    cls.set();
+                    for(auto w : {' ', '\t', '\n', '\v', '\f', '\r'}) cls.reset(static_cast<unsigned char>(w));
+                    s |= cls;
+                    return true;
+                }
+                case 'n': s.set('\n'); return true;
+                case 'r': s.set('\r'); return true;
+                case 't': s.set('\t'); return true;
+                case 'f': s.set('\f'); return true;
+                case 'v': s.set('\v'); return true;
+                case '0': s.set(0); return true;
+                case 'b':
+                    if(!inClass)
+                        return false; // word boundary
+                    s.set('\b');
+                    return true;
+                case 'x':
+                {
+                    if(i + 2 > str.size())
+                        return false;
+                    uint32_t v = 0;
+                    for(int k = 0; k < 2; k++)
+                    {
+                        auto h = str[i++];
+                        v *= 16;
+                        if(h >= '0' && h <= '9')      v += static_cast<uint32_t>(h - '0');
+                        else if(h >= 'a' && h <= 'f') v += static_cast<uint32_t>(h - 'a' + 10);
+                        else if(h >= 'A' && h <= 'F') v += static_cast<uint32_t>(h - 'A' + 10);
+                        else return false;
+                    }
+                    s.set(v);
+                    return true;
+                }
+                default:
+                    // back references, \B, \c, \u, \k, etc
+                    if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '1' && c <= '9'))
+                        return false;
+                    s.set(static_cast<unsigned char>(c));
+                    return true;
+            }
+        }
+
+        // the class after the '['
+        bool charClass(CharSet & s)
+        {
+            bool negate = false;
+            if(!done() && peek() == '^')
+            {
+                negate = true;
+                ++i;
+            }
+            while(true)
+            {
+                if(done())
+                    return false;
+                if(peek() == ']')
+                {
+                    ++i;
+                    break;
+                }
+
+                // a single character, or an escape which may be a set (eg: \d)
+                CharSet item;
+                int first = -1;
+                if(peek() == '\\')
+                {
+                    ++i;
+                    if(!escape(item, true))
+                        return false;
+                    if(item.count() == 1)
+                        first = static_cast<int>(_firstBit(item));
+                }
+                else
+                {
+                    first = static_cast<unsigned char>(peek());
+                    item.set(static_cast<size_t>(first));
+                    ++i;
+                }
+
+                // ranges, eg: a-z
+                if(first >= 0 && i + 1 < str.size() && peek() == '-' && str[i+1] != ']')
+                {
+                    ++i;
+                    int last = -1;
+                    if(peek() == '\\')
+                    {
+                        ++i;
+                        CharSet end;
+                        if(!escape(end, true) || end.count() != 1)
+                            return false;
+                        last = static_cast<int>(_firstBit(end));
+                    }
+                    else
+                    {
+                        last = static_cast<unsigned char>(peek());
+                        ++i;
+                    }
+                    if(last < first)
+                        return false;
+                    for(int x = first; x <= last; x++)
+                        item.set(static_cast<size_t>(x));
+                }
+                s |= item;
+            }
+            if(negate)
+                s.flip();
+            return true;
+        }
+
+        static size_t _firstBit(CharSet const & s)
+        {
+            for(size_t b = 0; b < s.size(); b++)
+                if(s.test(b))
+                    return b;
+            return 0;
+        }
+    };
+
+    bool _emit(Node const & n)
+    {
+        if(m_program.size() > maxInstructions)
+            return false;
+        switch(n.kind)
+        {
+            case Node::Empty:
+                return true;
+            case Node::Set:
+                m_program.push_back({Op::Set, n.set, 0});
+                return true;
+            case Node::Bol:
+                m_program.push_back({Op::Bol, 0, 0});
+                return true;
+            case Node::Eol:
+                m_program.push_back({Op::Eol, 0, 0});
+                return true;
+            case Node::Concat:
+                for(auto & c : n.children)
+                {
+                    if(!_emit(c))
+                        return false;
+                }
+                return true;
+            case Node::Alt:
+            {
+                std::vector<size_t> jumps;
+                for(size_t k = 0; k < n.children.size(); k++)
+                {
+                    size_t split = 0;
+                    bool last = k + 1 == n.children.size();
+                    if(!last)
+                    {
+                        split = m_program.size();
+                        m_program.push_back({Op::Split, _pc() + 1, 0});
+                    }
+                    if(!_emit(n.children[k]))
+                        return false;
+                    if(!last)
+                    {
+                        jumps.push_back(m_program.size());
+                        m_program.push_back({Op::Jmp, 0, 0});
+                        m_program[split].y = _pc();
+                    }
+                }
+                for(auto j : jumps)
+                    m_program[j].x = _pc();
+                return true;
+            }
+            case Node::Repeat:
+            {
+                auto & body = n.children.front();
+                for(uint32_t k = 0; k < n.min; k++)
+                {
+                    if(!_emit(body))
+                        return false;
+                }
+                if(n.max == infinite)
+                {
+                    // L: split body, end; body; jmp L
+                    auto split = m_program.size();
+                    m_program.push_back({Op::Split, _pc() + 1, 0});
+                    if(!_emit(body))
+                        return false;
+                    m_program.push_back({Op::Jmp, static_cast<uint32_t>(split), 0});
+                    m_program[split].y = _pc();
+                    return true;
+                }
+                // each optional copy can skip to the end
+                std::vector<size_t> splits;
+                for(uint32_t k = n.min; k < n.max; k++)
+                {
+                    splits.push_back(m_program.size());
+                    m_program.push_back({Op::Split, _pc() + 1, 0});
+                    if(!_emit(body))
+                        return false;
+                }
+                for(auto s : splits)
+                    m_program[s].y = _pc();
+                return m_program.size() <= maxInstructions;
+            }
+        }
+        return false;
+    }
+
+    uint32_t _pc() const
+    {
+        return static_cast<uint32_t>(m_program.size());
+    }
+
+    /**
+     * @brief _closure
+     *
+     * Follows the epsilon transitions from the pcs in stack, adding
+     * the Set, Eol and Match instructions that are reached to out.
+     * Eol is followed only if atEnd is true.
+     */
+    void _closure(std::vector<uint32_t> & stack, std::vector<uint32_t> & out, std::vector<uint8_t> & visited, bool atBegin, bool atEnd) const
+    {
+        std::fill(visited.begin(), visited.end(), uint8_t(0));
+        out.clear();
+        while(!stack.empty())
+        {
+            auto pc = stack.back();
+            stack.pop_back();
+            if(visited[pc])
+                continue;
+            visited[pc] = 1;
+            auto & I = m_program[pc];
+            switch(I.op)
+            {
+                case Op::Split: stack.push_back(I.y); stack.push_back(I.x); break;
+                case Op::Jmp:   stack.push_back(I.x); break;
+                case Op::Bol:   if(atBegin) stack.push_back(pc + 1); break;
+                case Op::Eol:
+                    if(atEnd)
+                        stack.push_back(pc + 1);
+                    else
+                        out.push_back(pc);
+                    break;
+                case Op::Set:
+                case Op::Match: out.push_back(pc); break;
+            }
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+    // the pcs after consuming c from the pcs in set, plus the start
+    // of the pattern, since the pattern can match anywhere
+    void _step(std::vector<uint32_t> const & set, unsigned char c, std::vector<uint32_t> & stack) const
+    {
+        stack.clear();
+        stack.push_back(0);
+        for(auto pc : set)
+        {
+            auto & I = m_program[pc];
+            if(I.op == Op::Set && m_sets[I.x].test(c))
+                stack.push_back(pc + 1);
+        }
+    }
+
+    State _classify(std::vector<uint32_t> const & set, std::vector<uint32_t> & stack, std::vector<uint32_t> & tmp, std::vector<uint8_t> & visited) const
+    {
+        State S;
+        stack.clear();
+        for(auto pc : set)
+        {
+            if(m_program[pc].op == Op::Match)
+                S.accept = true;
+            else if(m_program[pc].op == Op::Eol)
+                stack.push_back(pc + 1);
+        }
+        _closure(stack, tmp, visited, false, true);
+        S.acceptAtEnd = S.accept || std::any_of(tmp.begin(), tmp.end(), [&](uint32_t pc) { return m_program[pc].op == Op::Match; });
+
+        // the start of the pattern is always added, so the DFA is only
+        // dead if the pattern is anchored to the beginning
+        S.dead = !S.accept && set.empty() && m_anchored;
+        return S;
+    }
+
+    bool _compile()
+    {
+        Node root;
+        Parser P{m_pattern, 0, m_sets};
+        if(!P.alternation(root) || !P.done())
+            return false;
+        if(!_emit(root))
+            return false;
+        m_program.push_back({Op::Match, 0, 0});
+
+        std::vector<uint32_t> stack, set, tmp;
+        std::vector<uint8_t>  visited(m_program.size());
+
+        // if the start of the pattern can not be reached after
+        // the first character, it is anchored to the beginning
+        stack.push_back(0);
+        _closure(stack, set, visited, false, false);
+        m_anchored = set.empty();
+
+        stack.assign(1, 0);
+        _closure(stack, set, visited, true, true);
+        m_matchesEmpty = std::any_of(set.begin(), set.end(), [&](uint32_t pc) { return m_program[pc].op == Op::Match; });
+
+        _buildClasses();
+        _buildDFA();
+        return true;
+    }
+
+    // bytes which are in the same sets behave the same way,
+    // so the DFA only needs a column per class
+    void _buildClasses()
+    {
+        m_classes.fill(0);
+        m_classCount = 1;
+        for(auto & s : m_sets)
+        {
+            std::map<std::pair<uint32_t, bool>, uint32_t> split;
+            for(size_t b = 0; b < 256; b++)
+            {
+                auto key = std::make_pair(m_classes[b], s.test(b));
+                auto it = split.emplace(key, static_cast<uint32_t>(split.size())).first;
+                m_classes[b] = it->second;
+            }
+            m_classCount = static_cast<uint32_t>(split.size());
+            if(m_classCount == 256)
+                break;
+        }
+    }
+
+    void _buildDFA()
+    {
+        std::vector<uint32_t> stack, set, tmp;
+        std::vector<uint8_t>  visited(m_program.size());
+
+        // a representative byte of each class
+        std::vector<unsigned char> representative(m_classCount);
+        for(size_t b = 256; b-- > 0; )
+            representative[m_classes[b]] = static_cast<unsigned char>(b);
+
+        std::map<std::vector<uint32_t>, uint32_t> ids;
+        std::vector<std::vector<uint32_t>> sets;
+
+        stack.assign(1, 0);
+        _closure(stack, set, visited, true, false);
+        ids.emplace(set, 0);
+        sets.push_back(set);
+        m_states.push_back(_classify(set, stack, tmp, visited));
+
+        for(size_t s = 0; s < sets.size(); s++)
+        {
+            m_table.resize((s + 1) * m_classCount);
+            for(uint32_t c = 0; c < m_classCount; c++)
+            {
+                _step(sets[s], representative[c], stack);
+                _closure(stack, set, visited, false, false);
+                auto it = ids.find(set);
+                if(it == ids.end())
+                {
+                    if(sets.size() >= maxStates)
+                    {
+                        // too many states, simulate the NFA instead
+                        m_table.clear();
+                        m_states.clear();
+                        return;
+                    }
+                    it = ids.emplace(set, static_cast<uint32_t>(sets.size())).first;
+                    sets.push_back(set);
+                    m_states.push_back(_classify(set, stack, tmp, visited));
+                }
+                m_table[s * m_classCount + c] = it->second;
+            }
+        }
+    }
+
+    // used when the DFA would have too many states
+    bool _simulate(std::string_view str) const
+    {
+        std::vector<uint32_t> stack, set, tmp;
+        std::vector<uint8_t>  visited(m_program.size());
+
+        stack.assign(1, 0);
+        _closure(stack, set, visited, true, false);
+        for(auto c : str)
+        {
+            auto S = _classify(set, stack, tmp, visited);
+            if(S.accept)
+                return true;
+            if(S.dead)
+                return false;
+            _step(set, static_cast<unsigned char>(c), stack);
+            _closure(stack, set, visited, false, false);
+        }
+        return _classify(set, stack, tmp, visited).acceptAtEnd;
+    }
+
+    std::string                  m_pattern;
+    std::unique_ptr<std::regex>  m_regex;
+
+    std::vector<CharSet>         m_sets;
+    std::vector<Inst>            m_program;
+    bool                         m_anchored     = false;
+    bool                         m_matchesEmpty = false;
+
+    std::array<uint32_t, 256>    m_classes = {};
+    uint32_t                     m_classCount = 0;
+    std::vector<uint32_t>        m_table;       // [state * m_classCount + class] = next state
+    std::vector<State>           m_states;
+};
+
+/**
+ * @brief The StringFormat enum
+ *
+ * The values of the "format" keyword that are checked. Any
+ * other format is ignored, as allowed by JSON Schema.
+ */
+enum class StringFormat : uint8_t
+{
+    None,
+    Date,       // 2024-02-29
+    Time,       // 13:45:00Z, 13:45:00.5+01:00
+    DateTime,   // 2024-02-29T13:45:00Z
+    Email,
+    Hostname,
+    IPv4,
+    IPv6,
+    Uri,        // scheme:rest, eg: https://example.com
+    Uuid
+};
+
+inline StringFormat toStringFormat(std::string_view format)
+{
+    if(format == "date")      return StringFormat::Date;
+    if(format == "time")      return StringFormat::Time;
+    if(format == "date-time") return StringFormat::DateTime;
+    if(format == "email")     return StringFormat::Email;
+    if(format == "hostname")  return StringFormat::Hostname;
+    if(format == "ipv4")      return StringFormat::IPv4;
+    if(format == "ipv6")      return StringFormat::IPv6;
+    if(format == "uri")       return StringFormat::Uri;
+    if(format == "uuid")      return StringFormat::Uuid;
+    return StringFormat::None;
+}
+
+namespace detail
+{
+
+inline bool _isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool _isHex(char c)   { return _isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+inline bool _isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+// reads exactly n digits from the front of str
+inline bool _readDigits(std::string_view & str, size_t n, int & value)
+{
+    if(str.size() < n)
+        return false;
+    value = 0;
+    for(size_t i = 0; i < n; i++)
+    {
+        if(!_isDigit(str[i]))
+            return false;
+        value = value * 10 + (str[i] - '0');
+    }
+    str.remove_prefix(n);
+    return true;
+}
+
+inline bool _readChar(std::string_view & str, char c)
+{
+    if(str.empty() || str.front() != c)
+        return false;
+    str.remove_prefix(1);
+    return true;
+}
+
+inline bool _matchesDate(std::string_view & str)
+{
+    int y, m, d;
+    if(!_readDigits(str, 4, y) || !_readChar(str, '-') || !_readDigits(str, 2, m) || !_readChar(str, '-') || !_readDigits(str, 2, d))
+        return false;
+    static constexpr int days[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if(m < 1 || m > 12 || d < 1 || d > days[m-1])
+        return false;
+    bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    return !(m == 2 && d == 29 && !leap);
+}
+
+inline bool _matchesTime(std::string_view & str)
+{
+    int h, m, s;
+    if(!_readDigits(str, 2, h) || !_readChar(str, ':') || !_readDigits(str, 2, m) || !_readChar(str, ':') || !_readDigits(str, 2, s))
+        return false;
+    if(h > 23 || m > 59 || s > 60)
+        return false;
+    if(_readChar(str, '.'))
+    {
+        if(str.empty() || !_isDigit(str.front()))
+            return false;
+        while(!str.empty() && _isDigit(str.front()))
+            str.remove_prefix(1);
+    }
+    if(_readChar(str, 'Z') || _readChar(str, 'z'))
+        return true;
+    if(!_readChar(str, '+') && !_readChar(str, '-'))
+        return false;
+    return _readDigits(str, 2, h) && _readChar(str, ':') && _readDigits(str, 2, m) && h <= 23 && m <= 59;
+}
+
+inline bool _matchesHostname(std::string_view str)
+{
+    if(str.empty() || str.size() > 253)
+        return false;
+    while(true)
+    {
+        auto i = str.find('.');
+        auto label = str.substr(0, i);
+        if(label.empty() || label.size() > 63 || label.front() == '-' || label.back() == '-')
+            return false;
+        for(auto c : label)
+        {
+            if(!_isAlpha(c) && !_isDigit(c) && c != '-')
+                return false;
+        }
+        if(i == std::string_view::npos)
+            return true;
+        str.remove_prefix(i + 1);
+    }
+}
+
+inline bool _matchesIPv4(std::string_view str)
+{
+    for(int k = 0; k < 4; k++)
+    {
+        if(k != 0 && !_readChar(str, '.'))
+            return false;
+        size_t n = 0;
+        int v = 0;
+        while(n < str.size() && n < 4 && _isDigit(str[n]))
+            v = v * 10 + (str[n++] - '0');
+        if(n == 0 || n > 3 || v > 255 || (n > 1 && str[0] == '0'))
+            return false;
+        str.remove_prefix(n);
+    }
+    return str.empty();
+}
+
+inline bool _matchesIPv6(std::string_view str)
+{
+    // the groups before and after the "::"
+    int groups = 0;
+    bool compressed = false;
+    if(str.substr(0, 2) == "::")
+    {
+        compressed = true;
+        str.remove_prefix(2);
+    }
+    while(!str.empty())
+    {
+        // an ipv4 address can be used for the last 2 groups
+        if(str.find('.') != std::string_view::npos && str.find(':') == std::string_view::npos)
+        {
+            if(!_matchesIPv4(str))
+                return false;
+            groups += 2;
+            break;
+        }
+        size_t n = 0;
+        while(n < str.size() && n < 5 && _isHex(str[n]))
+            n++;
+        if(n == 0 || n > 4)
+            return false;
+        str.remove_prefix(n);
+        groups++;
+        if(str.empty())
+            break;
+        if(!_readChar(str, ':'))
+            return false;
+        if(_readChar(str, ':'))
+        {
+            if(compressed)
+                return false;
+            compressed = true;
+            if(str.empty())
+                break;
+        }
+        else if(str.empty())
+        {
+            return false;
+        }
+    }
+    return compressed ? groups < 8 : groups == 8;
+}
+
+inline bool _matchesFormat(StringFormat format, std::string_view str)
+{
+    switch(format)
+    {
+        case StringFormat::None:
+            return true;
+        case StringFormat::Date:
+            return _matchesDate(str) && str.empty();
+        case StringFormat::Time:
+            return _matchesTime(str) && str.empty();
+        case StringFormat::DateTime:
+            return _matchesDate(str) && (_readChar(str, 'T') || _readChar(str, 't')) && _matchesTime(str) && str.empty();
+        case StringFormat::Email:
+        {
+            auto at = str.rfind('@');
+            if(at == 0 || at == std::string_view::npos)
+                return false;
+            for(auto c : str.substr(0, at))
+            {
+                if(c == ' ' || c == '@' || static_cast<unsigned char>(c) < 0x20)
+                    return false;
+            }
+            return _matchesHostname(str.substr(at + 1));
+        }
+        case StringFormat::Hostname:
+            return _matchesHostname(str);
+        case StringFormat::IPv4:
+            return _matchesIPv4(str);
+        case StringFormat::IPv6:
+            return _matchesIPv6(str);
+        case StringFormat::Uri:
+        {
+            auto colon = str.find(':');
+            if(colon == 0 || colon == std::string_view::npos || !_isAlpha(str.front()))
+                return false;
+            for(auto c : str.substr(0, colon))
+            {
+                if(!_isAlpha(c) && !_isDigit(c) && c != '+' && c != '-' && c != '.')
+                    return false;
+            }
+            for(auto c : str)
+            {
+                if(c == ' ' || c == '"' || c == '<' || c == '>' || c == '\\' || c == '^' || c == '`' || c == '{' || c == '|' || c == '}' || static_cast<unsigned char>(c) < 0x20)
+                    return false;
+            }
+            return true;
+        }
+        case StringFormat::Uuid:
+        {
+            if(str.size() != 36)
+                return false;
+            for(size_t i = 0; i < str.size(); i++)
+            {
+                bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+                if(dash ? str[i] != '-' : !_isHex(str[i]))
+                    return false;
+            }
+            return true;
+        }
+    }
+    return true;
+}
+
+}
+
+/**
+ * @brief matchesFormat
+ * @param format
+ * @param str
+ * @return
+ *
+ * Returns true if str is a valid string of the format. Formats
+ * that are not known always match.
+ */
+inline bool matchesFormat(StringFormat format, std::string_view str)
+{
+    return detail::_matchesFormat(format, str);
+}
+
+inline bool matchesFormat(std::string_view format, std::string_view str)
+{
+    return detail::_matchesFormat(toStringFormat(format), str);
+}
+
+/**
+ * @brief The StringMatcherCache class
+ *
+ * Shares the compiled StringMatchers of the patterns, so each pattern
+ * is only compiled once no matter how many schemas, widgets or frames
+ * use it. The cache can be shared between threads.
+ */
+class StringMatcherCache
+{
+public:
+    /**
+     * @brief get
+     * @param pattern
+     * @return
+     *
+     * Returns the matcher of the pattern, compiling it if it is not
+     * in the cache. Returns nullptr if the pattern is invalid, invalid
+     * patterns are cached too so they are not compiled again.
+     */
+    std::shared_ptr<StringMatcher const> get(std::string_view pattern)
+    {
+        std::lock_guard<std::mutex> L(m_mutex);
+        auto it = m_matchers.find(pattern);
+        if(it != m_matchers.end())
+            return it->second;
+        std::shared_ptr<StringMatcher const> M;
+        try
+        {
+            M = std::make_shared<StringMatcher const>(pattern);
+        }
+        catch(std::regex_error &)
+        {
+        }
+        m_matchers.emplace(std::string(pattern), M);
+        return M;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> L(m_mutex);
+        m_matchers.clear();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> L(m_mutex);
+        return m_matchers.size();
+    }
+
+protected:
+    mutable std::mutex                                                 m_mutex;
+    std::map<std::string, std::shared_ptr<StringMatcher const>, std::less<> > m_matchers;
+};
+
+/**
+ * @brief getStringMatcherCache
+ * @return
+ *
+ * Returns the cache used by the validator and the string widgets
+ */
+inline StringMatcherCache & getStringMatcherCache()
+{
+    static StringMatcherCache cache;
+    return cache;
+}
+
+}
+
+#endif
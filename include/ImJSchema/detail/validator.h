@@ -0,0 +1,832 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the compiled validator, which checks
+// a json value against the constraints of a json schema
+//
+#ifndef IMJSCHEMA_VALIDATOR_H
+#define IMJSCHEMA_VALIDATOR_H
+
+#include "json_utils.h"
+#include "string_matcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ImJSchema
+{
+
+/**
+ * @brief The ValidationErrors class
+ *
+ * The error messages of a value, keyed by the json pointer
+ * (eg: "/position/0") to the value that is invalid. The
+ * root value has the pointer "".
+ */
+class ValidationErrors
+{
+public:
+    using map_type = std::map<std::string, std::vector<std::string>, std::less<> >;
+
+    void add(std::string_view path, std::string message)
+    {
+        auto it = m_errors.find(path);
+        if(it == m_errors.end())
+            it = m_errors.emplace(std::string(path), std::vector<std::string>()).first;
+        it->second.push_back(std::move(message));
+    }
+
+    /**
+     * @brief find
+     * @param path
+     * @return
+     *
+     * Returns the messages for the value at path, or
+     * nullptr if it is valid
+     */
+    std::vector<std::string> const * find(std::string_view path) const
+    {
+        auto it = m_errors.find(path);
+        return it == m_errors.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * @brief erase
+     * @param path
+     *
+     * Erases the messages of the value at path, but
+     * not of its children
+     */
+    void erase(std::string_view path)
+    {
+        auto it = m_errors.find(path);
+        if(it != m_errors.end())
+            m_errors.erase(it);
+    }
+
+    /**
+     * @brief eraseSubtree
+     * @param path
+     *
+     * Erases the messages of the value at path and
+     * all of its children
+     */
+    void eraseSubtree(std::string_view path)
+    {
+        auto it = m_errors.lower_bound(path);
+        while(it != m_errors.end() && std::string_view(it->first).substr(0, path.size()) == path)
+        {
+            auto & key = it->first;
+            if(key.size() == path.size() || key[path.size()] == '/')
+                it = m_errors.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void merge(ValidationErrors && other)
+    {
+        for(auto & [path, messages] : other.m_errors)
+        {
+            for(auto & m : messages)
+                add(path, std::move(m));
+        }
+        other.clear();
+    }
+
+    void clear()
+    {
+        m_errors.clear();
+    }
+
+    bool empty() const
+    {
+        return m_errors.empty();
+    }
+
+    // number of values that have errors
+    size_t size() const
+    {
+        return m_errors.size();
+    }
+
+    map_type::const_iterator begin() const { return m_errors.begin(); }
+    map_type::const_iterator end()   const { return m_errors.end(); }
+
+protected:
+    map_type m_errors;
+};
+
+/**
+ * @brief The ValidatorNode struct
+ *
+ * The constraints of a single schema object
+ */
+struct ValidatorNode
+{
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    enum TypeBits : uint32_t
+    {
+        Null    = 1u << 0,
+        Boolean = 1u << 1,
+        Object  = 1u << 2,
+        Array   = 1u << 3,
+        Number  = 1u << 4,
+        Integer = 1u << 5,
+        String  = 1u << 6
+    };
+
+    json const * schema = nullptr;
+
+    uint32_t types = 0; // allowed types, 0 allows all types
+
+    // numbers
+    bool   hasMinimum          = false;
+    bool   hasMaximum          = false;
+    bool   hasExclusiveMinimum = false;
+    bool   hasExclusiveMaximum = false;
+    double minimum             = 0.0;
+    double maximum             = 0.0;
+    double exclusiveMinimum    = 0.0;
+    double exclusiveMaximum    = 0.0;
+    double multipleOf          = 0.0; // 0 if not given
+
+    // strings
+    size_t minLength = 0;
+    size_t maxLength = std::numeric_limits<size_t>::max();
+    std::shared_ptr<StringMatcher const> pattern;   // shared with getStringMatcherCache()
+    StringFormat format = StringFormat::None;
+
+    // arrays
+    size_t   minItems    = 0;
+    size_t   maxItems    = std::numeric_limits<size_t>::max();
+    bool     uniqueItems = false;
+    uint32_t items       = npos;
+
+    // objects
+    size_t   minProperties = 0;
+    size_t   maxProperties = std::numeric_limits<size_t>::max();
+    uint32_t firstRequired = 0;   // range within CompiledValidator::required
+    uint32_t requiredCount = 0;
+    uint32_t firstProperty = 0;   // range within CompiledValidator::properties
+    uint32_t propertyCount = 0;   //    sorted by name
+
+    // oneOf
+    uint32_t firstAlternative = 0;
+    uint32_t alternativeCount = 0;
+
+    json const * enumValues = nullptr;
+    json const * constValue = nullptr;
+};
+
+/**
+ * @brief The CompiledValidator struct
+ *
+ * A json schema compiled into a flat array of validator nodes,
+ * nodes[0] is the root. Use compileValidator( ) to create one, and
+ * validate( )/revalidate( ) to check a value.
+ *
+ * The CompiledValidator is not modified when validating, so it
+ * can be shared between forms and threads.
+ */
+struct CompiledValidator
+{
+    struct Property
+    {
+        std::string const * name = nullptr;
+        uint32_t            node = ValidatorNode::npos;
+    };
+
+    std::shared_ptr<json const>        source;
+    std::vector<ValidatorNode>         nodes;
+    std::vector<Property>              properties;
+    std::vector<std::string const*>    required;
+    std::vector<uint32_t>              alternatives;
+
+    bool empty() const
+    {
+        return nodes.empty();
+    }
+
+    /**
+     * @brief findProperty
+     * @param node
+     * @param name
+     * @return
+     *
+     * Returns the node of the property of an object node, or npos
+     */
+    uint32_t findProperty(uint32_t node, std::string_view name) const
+    {
+        auto & N = nodes[node];
+        auto _begin = properties.begin() + N.firstProperty;
+        auto _end   = _begin + N.propertyCount;
+        auto it = std::lower_bound(_begin, _end, name, [](Property const & P, std::string_view n)
+        {
+            return std::string_view(*P.name) < n;
+        });
+        if(it == _end || *it->name != name)
+            return ValidatorNode::npos;
+        return it->node;
+    }
+};
+
+namespace detail
+{
+
+inline uint32_t _validatorTypeBits(std::string_view type)
+{
+    if(type == "null")    return ValidatorNode::Null;
+    if(type == "boolean") return ValidatorNode::Boolean;
+    if(type == "object")  return ValidatorNode::Object;
+    if(type == "array")   return ValidatorNode::Array;
+    if(type == "number")  return ValidatorNode::Number | ValidatorNode::Integer;
+    if(type == "integer") return ValidatorNode::Integer;
+    if(type == "string")  return ValidatorNode::String;
+    return 0;
+}
+
+inline uint32_t _compileValidatorNode(CompiledValidator & V, json const & schema)
+{
+    auto index = static_cast<uint32_t>(V.nodes.size());
+    V.nodes.emplace_back();
+
+    ValidatorNode N;
+    N.schema = &schema;
+    if(!schema.is_object())
+    {
+        V.nodes[index] = N;
+        return index;
+    }
+
+    doIfKeyExists("type", schema, [&](auto & t)
+    {
+        if(t.is_string())
+        {
+            N.types = _validatorTypeBits(t.template get_ref<std::string const&>());
+        }
+        else if(t.is_array())
+        {
+            for(auto & a : t)
+            {
+                if(a.is_string())
+                    N.types |= _validatorTypeBits(a.template get_ref<std::string const&>());
+            }
+        }
+    });
+
+    auto _number = [&](char const * key, bool & has, double & v)
+    {
+        auto it = schema.find(key);
+        if(it != schema.end() && it->is_number())
+        {
+            has = true;
+            v = it->get<double>();
+        }
+    };
+    bool hasMultipleOf = false;
+    _number("minimum",          N.hasMinimum,          N.minimum);
+    _number("maximum",          N.hasMaximum,          N.maximum);
+    _number("exclusiveMinimum", N.hasExclusiveMinimum, N.exclusiveMinimum);
+    _number("exclusiveMaximum", N.hasExclusiveMaximum, N.exclusiveMaximum);
+    _number("multipleOf",       hasMultipleOf,         N.multipleOf);
+    if(N.multipleOf <= 0.0)
+        N.multipleOf = 0.0;
+
+    N.minLength     = JValue(schema, "minLength",     N.minLength);
+    N.maxLength     = JValue(schema, "maxLength",     N.maxLength);
+    N.minItems      = JValue(schema, "minItems",      N.minItems);
+    N.maxItems      = JValue(schema, "maxItems",      N.maxItems);
+    N.uniqueItems   = JValue(schema, "uniqueItems",   N.uniqueItems);
+    N.minProperties = JValue(schema, "minProperties", N.minProperties);
+    N.maxProperties = JValue(schema, "maxProperties", N.maxProperties);
+
+    if(auto pattern = JStringRef(schema, "pattern"))
+    {
+        N.pattern = getStringMatcherCache().get(*pattern);
+        if(!N.pattern)
+            throw std::runtime_error("Invalid \"pattern\": " + *pattern);
+    }
+    N.format = toStringFormat(JValueView(schema, "format"));
+
+    auto enum_it = schema.find("enum");
+    if(enum_it != schema.end() && enum_it->is_array())
+        N.enumValues = &*enum_it;
+    auto const_it = schema.find("const");
+    if(const_it != schema.end())
+        N.constValue = &*const_it;
+
+    auto required_it = schema.find("required");
+    if(required_it != schema.end() && required_it->is_array())
+    {
+        N.firstRequired = static_cast<uint32_t>(V.required.size());
+        for(auto & r : *required_it)
+        {
+            if(r.is_string())
+                V.required.push_back(&r.get_ref<std::string const&>());
+        }
+        N.requiredCount = static_cast<uint32_t>(V.required.size()) - N.firstRequired;
+    }
+
+    // the properties are sorted by name (json objects are already
+    // sorted) so they can be found with a binary search
+    auto properties_it = schema.find("properties");
+    if(properties_it != schema.end() && properties_it->is_object())
+    {
+        N.firstProperty = static_cast<uint32_t>(V.properties.size());
+        N.propertyCount = static_cast<uint32_t>(properties_it->size());
+        V.properties.resize(V.properties.size() + properties_it->size());
+        uint32_t i = 0;
+        for(auto p_it = properties_it->begin(); p_it != properties_it->end(); ++p_it)
+        {
+            V.properties[N.firstProperty + i].name = &p_it.key();
+            i++;
+        }
+        std::sort(V.properties.begin() + N.firstProperty, V.properties.end(), [](auto & a, auto & b)
+        {
+            return *a.name < *b.name;
+        });
+        for(i = 0; i < N.propertyCount; i++)
+        {
+            auto n = _compileValidatorNode(V, properties_it->at(*V.properties[N.firstProperty + i].name));
+            V.properties[N.firstProperty + i].node = n;
+        }
+    }
+
+    auto oneOf_it = schema.find("oneOf");
+    if(oneOf_it != schema.end() && oneOf_it->is_array())
+    {
+        N.firstAlternative = static_cast<uint32_t>(V.alternatives.size());
+        N.alternativeCount = static_cast<uint32_t>(oneOf_it->size());
+        V.alternatives.resize(V.alternatives.size() + oneOf_it->size());
+        uint32_t i = 0;
+        for(auto & alt : *oneOf_it)
+        {
+            auto n = _compileValidatorNode(V, alt);
+            V.alternatives[N.firstAlternative + i++] = n;
+        }
+    }
+
+    auto items_it = schema.find("items");
+    if(items_it != schema.end() && items_it->is_object())
+    {
+        N.items = _compileValidatorNode(V, *items_it);
+    }
+
+    V.nodes[index] = N;
+    return index;
+}
+
+inline bool _validatorTypeMatches(uint32_t types, json const & value)
+{
+    if(types == 0)
+        return true;
+    switch(value.type())
+    {
+        case json::value_t::null:            return types & ValidatorNode::Null;
+        case json::value_t::boolean:         return types & ValidatorNode::Boolean;
+        case json::value_t::object:          return types & ValidatorNode::Object;
+        case json::value_t::array:           return types & ValidatorNode::Array;
+        case json::value_t::string:          return types & ValidatorNode::String;
+        case json::value_t::number_integer:
+        case json::value_t::number_unsigned: return types & (ValidatorNode::Integer | ValidatorNode::Number);
+        case json::value_t::number_float:
+        {
+            if(types & ValidatorNode::Number)
+                return true;
+            // 1.0 is an integer
+            auto d = value.get<double>();
+            return (types & ValidatorNode::Integer) && std::isfinite(d) && std::floor(d) == d;
+        }
+        default:
+            return false;
+    }
+}
+
+inline std::string _validatorNumberString(double d)
+{
+    auto s = json(d).dump();
+    if(s.size() > 2 && s.compare(s.size()-2, 2, ".0") == 0)
+        s.resize(s.size()-2);
+    return s;
+}
+
+inline void _appendPointerToken(std::string & path, std::string_view token)
+{
+    path.push_back('/');
+    for(auto c : token)
+    {
+        if(c == '~')
+            path.append("~0");
+        else if(c == '/')
+            path.append("~1");
+        else
+            path.push_back(c);
+    }
+}
+
+inline std::string _validatorTypeNames(uint32_t types)
+{
+    static constexpr std::pair<uint32_t, char const*> names[] = {
+        {ValidatorNode::Null,    "null"},
+        {ValidatorNode::Boolean, "boolean"},
+        {ValidatorNode::Object,  "object"},
+        {ValidatorNode::Array,   "array"},
+        {ValidatorNode::Number,  "number"},
+        {ValidatorNode::String,  "string"}
+    };
+    std::string str;
+    for(auto & [bit, name] : names)
+    {
+        if(!(types & bit))
+            continue;
+        if(!str.empty())
+            str += " or ";
+        str += name;
+    }
+    if(!(types & ValidatorNode::Number) && (types & ValidatorNode::Integer))
+        str += str.empty() ? "integer" : " or integer";
+    return str;
+}
+
+/**
+ * @brief _validateShallow
+ *
+ * Checks the constraints of the node that only depend on the value
+ * itself and not on the constraints of its children. The errors
+ * are added to errors[path].
+ *
+ * Returns false if the value is not the correct type, in which
+ * case the children should not be checked.
+ */
+inline bool _validateShallow(CompiledValidator const & V, uint32_t node, json const & value, std::string const & path, ValidationErrors & errors)
+{
+    auto & N = V.nodes[node];
+
+    if(!_validatorTypeMatches(N.types, value))
+    {
+        errors.add(path, "must be of type " + _validatorTypeNames(N.types));
+        return false;
+    }
+
+    if(N.enumValues && std::find(N.enumValues->begin(), N.enumValues->end(), value) == N.enumValues->end())
+        errors.add(path, "must be one of " + N.enumValues->dump());
+    if(N.constValue && *N.constValue != value)
+        errors.add(path, "must be " + N.constValue->dump());
+
+    if(value.is_number())
+    {
+        auto d = value.get<double>();
+        if(N.hasMinimum && d < N.minimum)
+            errors.add(path, "must be >= " + _validatorNumberString(N.minimum));
+        if(N.hasMaximum && d > N.maximum)
+            errors.add(path, "must be <= " + _validatorNumberString(N.maximum));
+        if(N.hasExclusiveMinimum && d <= N.exclusiveMinimum)
+            errors.add(path, "must be > " + _validatorNumberString(N.exclusiveMinimum));
+        if(N.hasExclusiveMaximum && d >= N.exclusiveMaximum)
+            errors.add(path, "must be < " + _validatorNumberString(N.exclusiveMaximum));
+        if(N.multipleOf > 0.0)
+        {
+            auto q = d / N.multipleOf;
+            if(std::abs(q - std::round(q)) > 1e-9 * std::max(1.0, std::abs(q)))
+                errors.add(path, "must be a multiple of " + _validatorNumberString(N.multipleOf));
+        }
+    }
+    else if(value.is_string())
+    {
+        auto & str = value.get_ref<std::string const&>();
+        if(N.minLength > 0 || N.maxLength < std::numeric_limits<size_t>::max())
+        {
+            // the length is the number of characters, not bytes
+            size_t length = 0;
+            for(auto c : str)
+                length += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+            if(length < N.minLength)
+                errors.add(path, "must be at least " + std::to_string(N.minLength) + " characters");
+            if(length > N.maxLength)
+                errors.add(path, "must be at most " + std::to_string(N.maxLength) + " characters");
+        }
+        if(N.pattern && !N.pattern->search(str))
+            errors.add(path, "must match the pattern " + N.pattern->pattern());
+        if(!matchesFormat(N.format, str))
+            errors.add(path, "must be a valid " + std::string(JValueView(*N.schema, "format")));
+    }
+    else if(value.is_array())
+    {
+        if(value.size() < N.minItems)
+            errors.add(path, "must have at least " + std::to_string(N.minItems) + " items");
+        if(value.size() > N.maxItems)
+            errors.add(path, "must have at most " + std::to_string(N.maxItems) + " items");
+        if(N.uniqueItems && value.size() > 1)
+        {
+            std::vector<json const*> sorted;
+            sorted.reserve(value.size());
+            for(auto & v : value)
+                sorted.push_back(&v);
+            std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return *a < *b; });
+            for(size_t i = 1; i < sorted.size(); i++)
+            {
+                if(*sorted[i-1] == *sorted[i])
+                {
+                    errors.add(path, "items must be unique");
+                    break;
+                }
+            }
+        }
+    }
+    else if(value.is_object())
+    {
+        if(value.size() < N.minProperties)
+            errors.add(path, "must have at least " + std::to_string(N.minProperties) + " properties");
+        if(value.size() > N.maxProperties)
+            errors.add(path, "must have at most " + std::to_string(N.maxProperties) + " properties");
+        for(uint32_t i = 0; i < N.requiredCount; i++)
+        {
+            auto & name = *V.required[N.firstRequired + i];
+            auto it = value.find(name);
+            if(it == value.end() || it->is_null())
+                errors.add(path, "requires the property \"" + name + "\"");
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief _isNumericItem
+ *
+ * Returns true if the item node only has bounds, so an array
+ * of them can use _validateNumbers( )
+ */
+inline bool _isNumericItem(ValidatorNode const & I)
+{
+    constexpr uint32_t numeric = ValidatorNode::Number | ValidatorNode::Integer;
+    return I.types != 0 && (I.types & ~numeric) == 0 &&
+           I.multipleOf == 0.0 && !I.enumValues && !I.constValue && I.alternativeCount == 0;
+}
+
+inline void _validate(CompiledValidator const & V, uint32_t node, json const & value, std::string & path, ValidationErrors & errors);
+
+/**
+ * @brief _validateNumbers
+ *
+ * Validates the items of an array of numbers. The items are copied
+ * into a contiguous buffer and their bounds are checked in blocks,
+ * only the items which fail (out of range, or not a number) are
+ * validated one by one to get their error messages.
+ */
+inline void _validateNumbers(CompiledValidator const & V, uint32_t items, json const & value, std::string & path, ValidationErrors & errors)
+{
+    auto & I = V.nodes[items];
+
+    NumericBounds B;
+    if(I.hasMinimum)          B.minimum          = I.minimum;
+    if(I.hasMaximum)          B.maximum          = I.maximum;
+    if(I.hasExclusiveMinimum) B.exclusiveMinimum = I.exclusiveMinimum;
+    if(I.hasExclusiveMaximum) B.exclusiveMaximum = I.exclusiveMaximum;
+
+    thread_local std::vector<double> buffer;
+    thread_local std::vector<size_t> failed;
+    _extractNumbers(value, buffer, !(I.types & ValidatorNode::Number));
+    failed.clear();
+    _findOutOfRange(buffer.data(), buffer.size(), B, failed);
+
+    auto size = path.size();
+    for(auto i : failed)
+    {
+        path.push_back('/');
+        path.append(std::to_string(i));
+        _validate(V, items, value[i], path, errors);
+        path.resize(size);
+    }
+}
+
+/**
+ * @brief _validate
+ *
+ * Checks the value and all of its children. path is the json pointer
+ * to the value, it is used as a buffer for the children's paths.
+ */
+inline void _validate(CompiledValidator const & V, uint32_t node, json const & value, std::string & path, ValidationErrors & errors)
+{
+    auto & N = V.nodes[node];
+
+    if(N.alternativeCount > 0)
+    {
+        // the value must match exactly one of the alternatives, if it
+        // matches none, report the errors of the alternative that was the
+        // closest: the one whose own constraints passed, then the fewest errors
+        ValidationErrors best;
+        auto _score = [&](ValidationErrors const & e)
+        {
+            return std::make_pair(e.find(path) != nullptr, e.size());
+        };
+        uint32_t matches = 0;
+        for(uint32_t i = 0; i < N.alternativeCount && matches < 2; i++)
+        {
+            ValidationErrors altErrors;
+            _validate(V, V.alternatives[N.firstAlternative + i], value, path, altErrors);
+            if(altErrors.empty())
+            {
+                matches++;
+                continue;
+            }
+            if(matches == 0 && (best.empty() || _score(altErrors) < _score(best)))
+                best = std::move(altErrors);
+        }
+        if(matches == 0)
+            errors.merge(std::move(best));
+        else if(matches > 1)
+            errors.add(path, "must match only one of the oneOf schemas");
+    }
+
+    if(!_validateShallow(V, node, value, path, errors))
+        return;
+
+    auto size = path.size();
+    if(value.is_object() && N.propertyCount > 0)
+    {
+        // both are sorted by name, so walk them together
+        auto P    = V.properties.begin() + N.firstProperty;
+        auto _end = P + N.propertyCount;
+        for(auto it = value.begin(); it != value.end() && P != _end; ++it)
+        {
+            while(P != _end && *P->name < it.key())
+                ++P;
+            if(P == _end || *P->name != it.key())
+                continue;
+            if(it->is_null())
+                continue; // optional properties which are not enabled, "required" reports the others
+            _appendPointerToken(path, it.key());
+            _validate(V, P->node, *it, path, errors);
+            path.resize(size);
+        }
+    }
+    else if(value.is_array() && N.items != ValidatorNode::npos)
+    {
+        if(value.size() >= 16 && _isNumericItem(V.nodes[N.items]))
+        {
+            _validateNumbers(V, N.items, value, path, errors);
+            return;
+        }
+        for(size_t i = 0; i < value.size(); i++)
+        {
+            path.push_back('/');
+            path.append(std::to_string(i));
+            _validate(V, N.items, value[i], path, errors);
+            path.resize(size);
+        }
+    }
+}
+
+}
+
+/**
+ * @brief compileValidator
+ * @param schema
+ * @return
+ *
+ * Compiles the constraints of the schema. The schema is copied
+ * into the validator, and any references in it should be expanded
+ * before compiling it.
+ *
+ * Supported keywords: type, enum, const, minimum, maximum,
+ * exclusiveMinimum, exclusiveMaximum, multipleOf, minLength,
+ * maxLength, pattern, format, minItems, maxItems, uniqueItems, items,
+ * required, minProperties, maxProperties, properties and oneOf.
+ * See StringFormat for the formats that are checked.
+ *
+ * A value is valid for a oneOf if it matches exactly one of
+ * the alternatives. A property that is null is treated as if it
+ * does not exist, the object widgets set the optional properties
+ * which are not enabled to null.
+ *
+ * Throws a std::runtime_error if a pattern is not a valid regex.
+ */
+inline CompiledValidator compileValidator(json schema)
+{
+    CompiledValidator V;
+    V.source = std::make_shared<json const>(std::move(schema));
+    detail::_compileValidatorNode(V, *V.source);
+    return V;
+}
+
+/**
+ * @brief validate
+ * @param V
+ * @param value
+ * @param errors
+ * @return
+ *
+ * Validates the entire value. errors is cleared first. Returns
+ * true if the value is valid.
+ */
+inline bool validate(CompiledValidator const & V, json const & value, ValidationErrors & errors)
+{
+    errors.clear();
+    if(V.empty())
+        return true;
+    std::string path;
+    detail::_validate(V, 0, value, path, errors);
+    return errors.empty();
+}
+
+/**
+ * @brief revalidate
+ * @param V
+ * @param value
+ * @param modified
+ * @param errors
+ * @return
+ *
+ * Updates errors after the value at the modified path has changed,
+ * eg: the path returned by getModifiedWidgetPath( ). errors must
+ * hold the result of a previous validate( ) of the same value.
+ *
+ * Only the modified subtree is validated, plus the constraints of
+ * its parents which do not depend on their children's constraints
+ * (eg: required, uniqueItems), so the cost is proportional to the
+ * size of the edit rather than the entire value. If a parent has a
+ * oneOf, that parent's subtree is validated instead.
+ *
+ * Returns true if the value is valid.
+ */
+inline bool revalidate(CompiledValidator const & V, json const & value, json::json_pointer const & modified, ValidationErrors & errors)
+{
+    if(V.empty())
+        return true;
+
+    // find the deepest value on the path, checking
+    // the parents on the way down
+    auto tokens = CompiledPath(modified.to_string());
+    uint32_t node = 0;
+    json const * J = &value;
+    std::string path;
+    for(auto & token : tokens)
+    {
+        auto & N = V.nodes[node];
+        if(N.alternativeCount > 0)
+            break;
+
+        uint32_t child = ValidatorNode::npos;
+        json const * childValue = nullptr;
+        if(J->is_object())
+        {
+            auto it = J->find(token.key);
+            child = V.findProperty(node, token.key);
+            childValue = it != J->end() ? &*it : nullptr;
+        }
+        else if(J->is_array() && token.index < J->size())
+        {
+            child = N.items;
+            childValue = &(*J)[token.index];
+        }
+        if(!childValue || child == ValidatorNode::npos || childValue->is_null())
+            break;
+
+        errors.erase(path);
+        detail::_validateShallow(V, node, *J, path, errors);
+
+        node = child;
+        J = childValue;
+        detail::_appendPointerToken(path, token.key);
+    }
+
+    errors.eraseSubtree(path);
+    detail::_validate(V, node, *J, path, errors);
+    return errors.empty();
+}
+
+}
+
+#endif
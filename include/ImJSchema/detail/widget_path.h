@@ -0,0 +1,136 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef IMJSCHEMA_WIDGET_PATH_H
+#define IMJSCHEMA_WIDGET_PATH_H
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ImJSchema
+{
+using json = nlohmann::json;
+
+namespace detail
+{
+
+/**
+ * @brief The WidgetPath class
+ *
+ * The path to the widget that is currently being drawn. This is
+ * pushed/popped for every widget, so it is stored as a stack of
+ * (offset, length) integers into a single character buffer. Once the
+ * buffers have grown to the depth of the form, pushing and popping
+ * does not allocate.
+ *
+ * The json_pointer is only created when toPointer() is called.
+ *
+ * The names are copied rather than stored as (node, index) integers
+ * because the json schema draw functions have no node ids, the
+ * labels of array items are temporary buffers, and the path is read
+ * by getModifiedWidgetPath() after the frame, when the schema that
+ * the node ids belong to may no longer exist.
+ */
+class WidgetPath
+{
+public:
+    void push(std::string_view name)
+    {
+        m_entries.push_back( {static_cast<uint32_t>(m_chars.size()), static_cast<uint32_t>(name.size())} );
+        m_chars.insert(m_chars.end(), name.begin(), name.end());
+    }
+
+    void pop()
+    {
+        if(m_entries.empty())
+            return;
+        m_chars.resize(m_entries.back().offset);
+        m_entries.pop_back();
+    }
+
+    /**
+     * @brief truncate
+     * @param depth
+     *
+     * Removes entries until there are only depth entries
+     */
+    void truncate(size_t depth)
+    {
+        while(m_entries.size() > depth)
+            pop();
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_chars.clear();
+    }
+
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+    std::string_view operator[](size_t i) const
+    {
+        auto & e = m_entries[i];
+        return std::string_view(m_chars.data() + e.offset, e.length);
+    }
+
+    /**
+     * @brief toPointer
+     * @param first
+     * @return
+     *
+     * Creates a json_pointer from the path, starting
+     * at entry index, first.
+     */
+    json::json_pointer toPointer(size_t first = 0) const
+    {
+        json::json_pointer p;
+        for(size_t i = first; i < m_entries.size(); i++)
+        {
+            p.push_back( std::string( (*this)[i] ) );
+        }
+        return p;
+    }
+
+protected:
+    struct Entry
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+    std::vector<Entry> m_entries;
+    std::vector<char>  m_chars;
+};
+
+}
+
+}
+
+#endif
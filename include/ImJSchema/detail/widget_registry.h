@@ -0,0 +1,356 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the widget registry, the table of
+// draw functions keyed by "type/ui:widget"
+//
+#ifndef IMJSCHEMA_WIDGET_REGISTRY_H
+#define IMJSCHEMA_WIDGET_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace ImJSchema
+{
+
+struct WidgetDrawInput;
+
+namespace detail
+{
+using widget_draw_function_type = std::function<bool(WidgetDrawInput &in) >;
+
+/**
+ * @brief The WidgetRegistry class
+ *
+ * Stores the widget draw functions. Each function is identified
+ * by its key: "[object,number,boolean,integer,string,array]/WIDGET_NAME"
+ *
+ * The type and widget names are interned, and each (type, widget) pair
+ * is given an id. The id can be resolved once (eg: when a schema
+ * is compiled) and used to get the draw function with an array lookup.
+ *
+ * Ids are never removed, so an id that was interned before the widget was
+ * registered will return the widget once it has been registered.
+ *
+ * The registry can be used like the std::map it replaces: begin( ),
+ * end( ), find( ), count( ) and erase( ) only see the keys which
+ * have a draw function, and iterating gives the
+ * std::pair<std::string const, widget_draw_function_type> entries.
+ *
+ *  WidgetRegistry widgets;
+ *  widgets["number/my_widget"] = [](WidgetDrawInput & in) { ... };
+ *
+ *  auto id = widgets.intern("number", "my_widget");
+ *  auto & drawFunction = widgets.get(id);
+ *
+ * The const functions never modify the registry, so any number
+ * of threads can draw with it as long as no widgets are registered
+ * (operator[], intern( ), erase( )) at the same time.
+ */
+class WidgetRegistry
+{
+public:
+    using id_type    = uint32_t;
+    using key_type   = std::string;
+    using value_type = std::pair<std::string const, widget_draw_function_type>;
+    static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+    /**
+     * @brief The Iterator class
+     *
+     * Iterates over the entries which have a draw function,
+     * skipping the ids which were only interned.
+     */
+    template<typename Entry, typename DequeIterator>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = WidgetRegistry::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = Entry *;
+        using reference         = Entry &;
+
+        Iterator() = default;
+        Iterator(DequeIterator it, DequeIterator end) : m_it(it), m_end(end)
+        {
+            _skip();
+        }
+
+        reference operator*() const  { return *m_it; }
+        pointer   operator->() const { return &*m_it; }
+
+        Iterator & operator++()
+        {
+            ++m_it;
+            _skip();
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            auto r = *this;
+            ++*this;
+            return r;
+        }
+        bool operator==(Iterator const & o) const { return m_it == o.m_it; }
+        bool operator!=(Iterator const & o) const { return m_it != o.m_it; }
+
+        // iterator to const_iterator
+        template<typename E = Entry, typename = std::enable_if_t<!std::is_const_v<E>>>
+        operator Iterator<value_type const, typename std::deque<value_type>::const_iterator>() const
+        {
+            return {m_it, m_end};
+        }
+
+    protected:
+        void _skip()
+        {
+            while(m_it != m_end && !m_it->second)
+                ++m_it;
+        }
+        DequeIterator m_it;
+        DequeIterator m_end;
+    };
+    using iterator       = Iterator<value_type, std::deque<value_type>::iterator>;
+    using const_iterator = Iterator<value_type const, std::deque<value_type>::const_iterator>;
+
+    WidgetRegistry() = default;
+
+    WidgetRegistry(std::initializer_list< std::pair<std::string_view, widget_draw_function_type> > init)
+    {
+        for(auto & [key, func] : init)
+        {
+            (*this)[key] = func;
+        }
+    }
+
+    // the registry contains string_views into its own storage
+    // so it cannot be copied
+    WidgetRegistry(WidgetRegistry const &) = delete;
+    WidgetRegistry & operator=(WidgetRegistry const &) = delete;
+
+    /**
+     * @brief operator []
+     * @param key
+     * @return
+     *
+     * Returns a reference to the draw function for "type/widget".
+     * An empty function is created if the key does not exist.
+     */
+    widget_draw_function_type & operator[](std::string_view key)
+    {
+        return m_entries[intern(key)].second;
+    }
+
+    /**
+     * @brief intern
+     * @param type
+     * @param widget
+     * @return
+     *
+     * Returns the id of the (type, widget) pair. If the pair
+     * does not exist, an empty slot is created for it.
+     */
+    id_type intern(std::string_view type, std::string_view widget)
+    {
+        auto key = _key(_internName(type), _internName(widget));
+        auto it = m_ids.find(key);
+        if(it != m_ids.end())
+            return it->second;
+
+        auto id = static_cast<id_type>(m_entries.size());
+        std::string name;
+        name.reserve(type.size() + widget.size() + 1);
+        name.append(type).append("/").append(widget);
+        m_entries.emplace_back(std::move(name), widget_draw_function_type());
+        m_ids.emplace(key, id);
+        return id;
+    }
+
+    id_type intern(std::string_view key)
+    {
+        auto [type, widget] = _split(key);
+        return intern(type, widget);
+    }
+
+    /**
+     * @brief findId
+     * @param type
+     * @param widget
+     * @return
+     *
+     * Returns the id of the (type, widget) pair, or npos
+     * if it has never been interned.
+     */
+    id_type findId(std::string_view type, std::string_view widget) const
+    {
+        auto t = m_names.find(type);
+        if(t == m_names.end())
+            return npos;
+        auto w = m_names.find(widget);
+        if(w == m_names.end())
+            return npos;
+
+        auto it = m_ids.find(_key(t->second, w->second));
+        return it == m_ids.end() ? npos : it->second;
+    }
+
+    id_type findId(std::string_view key) const
+    {
+        auto [type, widget] = _split(key);
+        return findId(type, widget);
+    }
+
+    /**
+     * @brief lookup
+     * @param type
+     * @param widget
+     * @return
+     *
+     * Returns a pointer to the draw function, or nullptr if
+     * there is no function registered for the (type, widget) pair
+     */
+    widget_draw_function_type const * lookup(std::string_view type, std::string_view widget) const
+    {
+        auto & f = get(findId(type, widget));
+        return f ? &f : nullptr;
+    }
+
+    /**
+     * @brief get
+     * @param id
+     * @return
+     *
+     * Returns the draw function for an id returned by intern(). The
+     * function is empty if nothing has been registered for that id,
+     * or if the id is npos.
+     */
+    widget_draw_function_type const & get(id_type id) const
+    {
+        static widget_draw_function_type const _empty;
+        return id < m_entries.size() ? m_entries[id].second : _empty;
+    }
+
+    iterator begin()              { return {m_entries.begin(), m_entries.end()}; }
+    iterator end()                { return {m_entries.end(),   m_entries.end()}; }
+    const_iterator begin() const  { return {m_entries.begin(), m_entries.end()}; }
+    const_iterator end() const    { return {m_entries.end(),   m_entries.end()}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const   { return end(); }
+
+    iterator find(std::string_view key)
+    {
+        auto id = findId(key);
+        if(id == npos || !m_entries[id].second)
+            return end();
+        return {m_entries.begin() + id, m_entries.end()};
+    }
+    const_iterator find(std::string_view key) const
+    {
+        auto id = findId(key);
+        if(id == npos || !m_entries[id].second)
+            return end();
+        return {m_entries.begin() + id, m_entries.end()};
+    }
+
+    size_t count(std::string_view key) const
+    {
+        return find(key) == end() ? 0u : 1u;
+    }
+
+    /**
+     * @brief erase
+     * @param key
+     * @return
+     *
+     * Removes the draw function of the key. Its id stays
+     * valid, but get( ) returns an empty function.
+     */
+    size_t erase(std::string_view key)
+    {
+        auto id = findId(key);
+        if(id == npos || !m_entries[id].second)
+            return 0;
+        m_entries[id].second = nullptr;
+        return 1;
+    }
+
+    // the number of keys with a draw function
+    size_t size() const
+    {
+        return static_cast<size_t>(std::distance(begin(), end()));
+    }
+    bool empty() const
+    {
+        return begin() == end();
+    }
+
+protected:
+    static uint64_t _key(id_type type, id_type widget)
+    {
+        return (static_cast<uint64_t>(type) << 32) | widget;
+    }
+
+    static std::pair<std::string_view, std::string_view> _split(std::string_view key)
+    {
+        auto i = key.find('/');
+        if(i == std::string_view::npos)
+            return {key, std::string_view()};
+        return {key.substr(0, i), key.substr(i+1)};
+    }
+
+    id_type _internName(std::string_view name)
+    {
+        auto it = m_names.find(name);
+        if(it != m_names.end())
+            return it->second;
+
+        auto id = static_cast<id_type>(m_nameStorage.size());
+        m_nameStorage.emplace_back(name);
+        m_names.emplace(m_nameStorage.back(), id);
+        return id;
+    }
+
+    std::deque<std::string>                      m_nameStorage; // deque, so the views in m_names remain valid
+    std::unordered_map<std::string_view, id_type> m_names;
+    std::unordered_map<uint64_t, id_type>        m_ids;
+    std::deque<value_type>                       m_entries;     // deque, so references from operator[] remain valid
+};
+
+}
+
+}
+
+#endif
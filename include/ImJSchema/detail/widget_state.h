@@ -0,0 +1,432 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides the typed widget state that is used
+// when drawing a compiled schema, instead of the json cache
+//
+#ifndef IMJSCHEMA_WIDGET_STATE_H
+#define IMJSCHEMA_WIDGET_STATE_H
+
+#include "compiled_schema.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ImJSchema
+{
+
+namespace detail
+{
+
+struct WidgetState;
+
+/**
+ * @brief The WidgetStateArena class
+ *
+ * Allocates WidgetStates in large blocks. Allocations are rounded
+ * up to a power of two, states which are deallocated are kept in a
+ * free list for their size and reused by the next allocation of
+ * the same size. The memory is only freed when the arena is
+ * cleared or destroyed.
+ */
+class WidgetStateArena
+{
+public:
+    explicit WidgetStateArena(size_t blockSize = 256) : m_blockSize(blockSize)
+    {
+    }
+
+    /**
+     * @brief allocate
+     * @param count
+     * @return
+     *
+     * Returns a pointer to count contiguous, default constructed states.
+     * There is space for sizeFor(count) states.
+     */
+    WidgetState * allocate(size_t count);
+
+    /**
+     * @brief deallocate
+     * @param states
+     * @param count
+     *
+     * Returns states which were allocated with allocate(count) to
+     * the arena, along with the children of each state.
+     */
+    void deallocate(WidgetState * states, size_t count);
+
+    /**
+     * @brief sizeFor
+     * @param count
+     * @return
+     *
+     * The number of states allocate(count) makes space for
+     */
+    static size_t sizeFor(size_t count)
+    {
+        return size_t{1} << _sizeClass(count);
+    }
+
+    /**
+     * @brief clear
+     *
+     * Frees all the states. Any pointer returned by allocate( )
+     * is invalid after this is called.
+     */
+    void clear()
+    {
+        m_blocks.clear();
+        m_free.clear();
+        m_used     = 0;
+        m_capacity = 0;
+    }
+
+    /**
+     * @brief capacity
+     * @return
+     *
+     * The total number of states that have been allocated
+     */
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    /**
+     * @brief used
+     * @return
+     *
+     * The number of states which are allocated and have
+     * not been deallocated.
+     */
+    size_t used() const
+    {
+        return m_inUse;
+    }
+
+protected:
+    static size_t _sizeClass(size_t count)
+    {
+        size_t c = 0;
+        while( (size_t{1} << c) < count )
+            ++c;
+        return c;
+    }
+
+    std::vector< std::unique_ptr<WidgetState[]> > m_blocks;
+    std::vector< std::vector<WidgetState*> >      m_free; // free lists indexed by size class
+    size_t m_blockSize = 256;
+    size_t m_blockCount = 0;   // size of the last block
+    size_t m_used = 0;         // number of states used in the last block
+    size_t m_capacity = 0;
+    size_t m_inUse = 0;
+};
+
+/**
+ * @brief The WidgetState struct
+ *
+ * The state of a single widget when drawing a compiled schema. This
+ * replaces the json cache which mirrored the entire value.
+ *
+ * The states of an object's properties (in compiled property order)
+ * or of an array's items are stored contiguously in children.
+ */
+struct WidgetState
+{
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    uint32_t enumIndex    = npos;   // selected index of an enum widget
+    uint32_t oneOfIndex   = npos;   // selected alternative of a oneOf object
+    float    maxLabelSize = 0.0f;   // width of the label column of an object
+    bool     disabled     = false;  // the optional property was removed by the user
+
+    json const *  childSource   = nullptr; // the source of the schema that childNode belongs to
+    uint32_t      childNode     = npos;    // the node whose properties are stored in children
+    uint32_t      childCount    = 0;
+    uint32_t      childCapacity = 0;
+    WidgetState * children      = nullptr;
+
+    json cache;                     // passed to the widget as WidgetDrawInput::cache
+
+    /**
+     * @brief property
+     * @param arena
+     * @param S
+     * @param node
+     * @param i
+     * @return
+     *
+     * Returns the state of the i'th property of the object node. If the
+     * states were allocated for a different node (eg: a different oneOf
+     * alternative was selected), the old states are returned to the
+     * arena and new states are allocated.
+     *
+     * Nodes are identified by the source of their schema, so that
+     * copies of S share the states, but lazily resolved
+     * references do not.
+     */
+    WidgetState & property(WidgetStateArena & arena, CompiledSchema const & S, uint32_t node, uint32_t i)
+    {
+        if(childNode != node || childSource != S.source.get())
+        {
+            auto count    = S.nodes[node].propertyCount;
+            releaseChildren(arena);
+            children      = arena.allocate(count);
+            childSource   = S.source.get();
+            childNode     = node;
+            childCount    = count;
+            childCapacity = static_cast<uint32_t>(WidgetStateArena::sizeFor(count));
+        }
+        return children[i];
+    }
+
+    /**
+     * @brief item
+     * @param arena
+     * @param i
+     * @return
+     *
+     * Returns the state of the i'th item of an array, growing
+     * the array of states if needed.
+     */
+    WidgetState & item(WidgetStateArena & arena, size_t i)
+    {
+        if(i >= childCapacity)
+        {
+            reserveItems(arena, std::max<size_t>({4u, i+1, size_t{childCapacity}*2}));
+        }
+        childSource = nullptr;
+        childNode   = npos;
+        childCount  = std::max(childCount, static_cast<uint32_t>(i+1));
+        return children[i];
+    }
+
+    /**
+     * @brief reserveItems
+     * @param arena
+     * @param count
+     *
+     * Makes sure there is space for count item states. The old
+     * states are moved and their memory is returned to the arena,
+     * so call this with the size of the array before calling item( )
+     */
+    void reserveItems(WidgetStateArena & arena, size_t count)
+    {
+        if(count <= childCapacity)
+            return;
+        auto newChildren = arena.allocate(count);
+        std::move(children, children + childCount, newChildren);
+
+        // the moved-from states still point to the children
+        // which now belong to the new states
+        std::fill(children, children + childCount, WidgetState());
+        arena.deallocate(children, childCapacity);
+
+        children      = newChildren;
+        childCapacity = static_cast<uint32_t>(WidgetStateArena::sizeFor(count));
+    }
+
+    void eraseItem(WidgetStateArena & arena, size_t i)
+    {
+        if(i >= childCount)
+            return;
+        children[i].releaseChildren(arena);
+        std::move(children + i + 1, children + childCount, children + i);
+        children[--childCount] = WidgetState();
+    }
+
+    void swapItems(size_t a, size_t b)
+    {
+        if(a < childCount && b < childCount)
+            std::swap(children[a], children[b]);
+    }
+
+    /**
+     * @brief releaseChildren
+     * @param arena
+     *
+     * Returns the children, and their children, to the arena
+     */
+    void releaseChildren(WidgetStateArena & arena)
+    {
+        arena.deallocate(children, childCapacity);
+        childSource   = nullptr;
+        childNode     = npos;
+        childCount    = 0;
+        childCapacity = 0;
+        children      = nullptr;
+    }
+
+    /**
+     * @brief reset
+     * @param arena
+     *
+     * Clears the state and returns its children to the arena
+     */
+    void reset(WidgetStateArena & arena)
+    {
+        releaseChildren(arena);
+        *this = WidgetState();
+    }
+
+    /**
+     * @brief reset
+     *
+     * Clears the state. The children remain in the arena
+     * until it is cleared, use this when the arena is about
+     * to be cleared too.
+     */
+    void reset()
+    {
+        *this = WidgetState();
+    }
+};
+
+inline WidgetState * WidgetStateArena::allocate(size_t count)
+{
+    if(count == 0)
+        return nullptr;
+
+    auto sizeClass = _sizeClass(count);
+    count = size_t{1} << sizeClass;
+    m_inUse += count;
+
+    if(sizeClass < m_free.size() && !m_free[sizeClass].empty())
+    {
+        auto p = m_free[sizeClass].back();
+        m_free[sizeClass].pop_back();
+        return p;
+    }
+
+    if(m_blocks.empty() || m_used + count > m_blockCount)
+    {
+        m_blockCount = std::max(count, m_blockSize);
+        m_blocks.emplace_back( new WidgetState[m_blockCount] );
+        m_capacity += m_blockCount;
+        m_used = 0;
+    }
+    auto p = m_blocks.back().get() + m_used;
+    m_used += count;
+    return p;
+}
+
+inline void WidgetStateArena::deallocate(WidgetState * states, size_t count)
+{
+    if(states == nullptr || count == 0)
+        return;
+
+    auto sizeClass = _sizeClass(count);
+    count = size_t{1} << sizeClass;
+
+    // the states are reset here so that allocate( ) can
+    // hand them out again as they are
+    for(size_t i = 0; i < count; i++)
+    {
+        states[i].releaseChildren(*this);
+        states[i] = WidgetState();
+    }
+
+    if(m_free.size() <= sizeClass)
+        m_free.resize(sizeClass + 1);
+    m_free[sizeClass].push_back(states);
+    m_inUse -= count;
+}
+
+/**
+ * @brief widgetStateToJson
+ * @param S
+ * @param node
+ * @param state
+ * @return
+ *
+ * Converts the state into the same layout as the json cache
+ * used when drawing a json schema. This is only used for
+ * debugging/serialization, it is not used when drawing.
+ */
+inline json widgetStateToJson(CompiledSchema const & S, uint32_t node, WidgetState const & state)
+{
+    json J = state.cache;
+    auto & N = S.nodes[node];
+
+    // the state of a reference belongs to the resolved schema,
+    // a reference that was never drawn has no state
+    if(N.isRef)
+        return N.resolved ? widgetStateToJson(*N.resolved, 0, state) : J;
+
+    if(N.type == SchemaType::Array && N.items != CompiledNode::npos)
+    {
+        J = json::array_t();
+        for(uint32_t i=0; i < state.childCount; i++)
+        {
+            J.push_back( widgetStateToJson(S, N.items, state.children[i]) );
+        }
+        return J;
+    }
+
+    if(!J.is_object())
+        J = json::object_t();
+
+    if(state.enumIndex != WidgetState::npos)
+        J["enumIndex"] = state.enumIndex;
+    if(state.oneOfIndex != WidgetState::npos)
+        J["oneOfIndex"] = state.oneOfIndex;
+    if(state.maxLabelSize > 0.0f)
+        J["max_label_size"] = state.maxLabelSize;
+
+    // the properties may belong to a oneOf alternative
+    // which was resolved into a different schema
+    auto * CS = &S;
+    for(uint32_t i=0; i < N.alternativeCount && CS->source.get() != state.childSource; i++)
+    {
+        auto & alt = S.nodes[S.alternatives[N.firstAlternative + i]];
+        if(alt.isRef && alt.resolved)
+            CS = alt.resolved;
+    }
+
+    if(state.childNode != WidgetState::npos && CS->source.get() == state.childSource)
+    {
+        auto & C = CS->nodes[state.childNode];
+        for(uint32_t i=0; i < state.childCount && i < C.propertyCount; i++)
+        {
+            auto & P = CS->properties[C.firstProperty + i];
+            auto & child = state.children[i];
+            J[*P.name] = widgetStateToJson(*CS, P.node, child);
+            if(child.disabled)
+                J["optional_items"][*P.name] = true;
+        }
+    }
+    return J;
+}
+
+}
+
+}
+
+#endif
@@ -38,8 +38,9 @@ struct MyApplication : public MainApplication
 public:
 
     IJS::json _schema;
+    IJS::CompiledSchema _compiledSchema;
+    IJS::FormState _formState;
     IJS::json _value = IJS::json::object_t();
-    IJS::json _cache = IJS::json::object_t();
     IJS::json::json_pointer _lastModifiedpath;
     IJS::json _lastModifiedValue;
 
@@ -74,6 +75,9 @@ public:
 
             return false;
         };
+
+        // compile the schema so it can be drawn
+        _compiledSchema = IJS::compileSchema(_schema);
     }
 
     /**
@@ -124,7 +128,7 @@ public:
         if(_update)
         {
             _value.clear();
-            _cache.clear();
+            _formState.clear();
             _lastModifiedpath = IJS::json::json_pointer{};
         }
 
@@ -146,10 +150,23 @@ public:
                 }
 
                 // POI: If the json Schema contains $ref then we need to expand the
-                // json object.
-                IJS::jsonExpandAllReferences(J);
+                // json object. This throws if a definition references itself
+                try
+                {
+                    IJS::jsonExpandAllReferences(J);
+                }
+                catch(std::exception & e)
+                {
+                    J = IJS::json::object_t();
+                    J["type"] = "object";
+                    J["description"] = e.what();
+                }
 
                 _schema = std::move(J);
+
+                // POI: Compile the schema once so that the schema properties
+                // do not need to be looked up every frame
+                _compiledSchema = IJS::compileSchema(_schema);
                 _update = false;
             }
             ImGui::PopItemWidth();
@@ -164,17 +181,16 @@ public:
         {
             // POI: This is the main function that is used to draw the actual widget
             //
-            // It requires 3 json objects:
+            // It requires 3 objects:
             //    1. a json object that the final value will be stored
-            //    2. a json object that defines the schema
-            //    3. a json object that can be use to cache data
+            //    2. the compiled schema
+            //    3. the FormState, which stores the state of the widgets between
+            //       frames and keeps track of whether the default values need
+            //       to be applied to the entire value
             //
-            // The WidgetDrawInput struct contains references to the objects
-            IJS::WidgetDrawInput in { "object", _value, _schema, _cache};
-
             // Draw the schema as a widget and return true if any of the values
             // have been modified
-            if(IJS::drawSchemaWidget(in))
+            if(IJS::drawSchemaWidget(_compiledSchema, _value, _formState))
             {
                 // We can get which widget within the entire Schema was modified using the
                 // getModifiedWidgetPath() function which returns a json_pointer object
@@ -204,7 +220,7 @@ public:
             }
             if(ImGui::CollapsingHeader("Schema Cache", ImGuiTreeNodeFlags_DefaultOpen))
             {
-                ImGui::TextUnformatted(_cache.dump(4).c_str());
+                ImGui::TextUnformatted(_formState.toJson(_compiledSchema).dump(4).c_str());
             }
 
             ImGui::EndChild();
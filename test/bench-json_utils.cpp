@@ -0,0 +1,164 @@
+#include <catch2/catch_all.hpp>
+
+#include "ImJSchema/detail/json_utils.h"
+#include "generator/schema_generator.h"
+
+//
+// Benchmarks of the json_utils.h functions that are also used outside
+// of the UI, eg: to preprocess the schemas on a server. Each one
+// is measured with a small, medium and huge input:
+//
+//   small  : one object with a few properties and one reference
+//   medium : generateSchema( ) with the default options
+//   huge   : wide objects, long arrays and many references
+//
+namespace
+{
+using namespace ImJSchema;
+
+generator::SchemaGeneratorOptions _options(char const * size)
+{
+    generator::SchemaGeneratorOptions opt;
+    if(std::string_view(size) == "small")
+    {
+        opt.depth       = 1;
+        opt.breadth     = 3;
+        opt.defCount    = 1;
+        opt.arrayLength = 4;
+    }
+    else if(std::string_view(size) == "huge")
+    {
+        opt.depth       = 3;
+        opt.breadth     = 32;
+        opt.defCount    = 8;
+        opt.refFanOut   = 4;
+        opt.oneOfCount  = 4;
+        opt.arrayLength = 64;
+    }
+    return opt;
+}
+
+/**
+ * @brief _deepestPath
+ * @param value
+ * @return
+ *
+ * The json pointer of the last item of the last array, following the
+ * "list" properties of a generated value down to a leaf.
+ */
+std::string _deepestPath(json const & value)
+{
+    std::string path;
+    json const * J = &value;
+    while(J->contains("list") && !J->at("list").empty())
+    {
+        auto last = J->at("list").size() - 1;
+        path += "/list/" + std::to_string(last);
+        J = &J->at("list").at(last);
+    }
+    return path + "/p0";
+}
+
+}
+
+TEST_CASE("json_utils benchmarks - jsonFindPath", "[benchmark]")
+{
+    for(auto size : {"small", "medium", "huge"})
+    {
+        auto opt   = _options(size);
+        auto value = generator::generateValue(generator::generateSchema(opt), opt.seed, opt.arrayLength);
+        auto path  = _deepestPath(value);
+        CompiledPath compiled(path);
+        REQUIRE(jsonFindPath(path, value) != nullptr);
+
+        BENCHMARK(std::string("jsonFindPath - string - ") + size)
+        {
+            return jsonFindPath(path, value);
+        };
+        BENCHMARK(std::string("jsonFindPath - CompiledPath - ") + size)
+        {
+            return jsonFindPath(compiled, value);
+        };
+    }
+}
+
+TEST_CASE("json_utils benchmarks - JValue", "[benchmark]")
+{
+    // the key is found in objects with an increasing number of keys
+    for(auto [size, keys] : {std::pair{"small", 4}, std::pair{"medium", 64}, std::pair{"huge", 4096}})
+    {
+        json J = json::object();
+        for(int i = 0; i < keys; i++)
+            J["key" + std::to_string(i)] = i;
+        J["minimum"] = 1.0;
+        J["type"]    = "number";
+
+        BENCHMARK(std::string("JValue - ") + size)
+        {
+            return JValue(J, "minimum", 0.0);
+        };
+        BENCHMARK(std::string("JValue - missing - ") + size)
+        {
+            return JValue(J, "maximum", 0.0);
+        };
+        BENCHMARK(std::string("JValueView - ") + size)
+        {
+            return JValueView(J, "type");
+        };
+    }
+}
+
+TEST_CASE("json_utils benchmarks - _jsonExpandReference", "[benchmark]")
+{
+    for(auto size : {"small", "medium", "huge"})
+    {
+        auto schema = generator::generateSchema(_options(size));
+        json const J = {{"$ref", "#/$defs/def0"}, {"title", "Title"}};
+
+        BENCHMARK_ADVANCED(std::string("_jsonExpandReference - ") + size)(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<json> values(static_cast<size_t>(meter.runs()), J);
+            meter.measure([&](int i) { _jsonExpandReference(values[static_cast<size_t>(i)], schema); });
+        };
+    }
+}
+
+TEST_CASE("json_utils benchmarks - jsonExpandAllReferences", "[benchmark]")
+{
+    for(auto size : {"small", "medium", "huge"})
+    {
+        auto schema = generator::generateSchema(_options(size));
+
+        BENCHMARK_ADVANCED(std::string("jsonExpandAllReferences - ") + size)(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<json> values(static_cast<size_t>(meter.runs()), schema);
+            meter.measure([&](int i) { jsonExpandAllReferences(values[static_cast<size_t>(i)]); });
+        };
+    }
+}
+
+TEST_CASE("json_utils benchmarks - initializeToDefaults", "[benchmark]")
+{
+    for(auto size : {"small", "medium", "huge"})
+    {
+        auto schema = generator::generateSchema(_options(size));
+        jsonExpandAllReferences(schema);
+
+        BENCHMARK(std::string("initializeToDefaults - ") + size)
+        {
+            json value;
+            initializeToDefaults(value, schema);
+            return value;
+        };
+
+        // the value already has all its defaults, eg: drawing a form
+        // without a FormState calls this every frame
+        json initialized;
+        initializeToDefaults(initialized, schema);
+        BENCHMARK(std::string("initializeToDefaults - initialized - ") + size)
+        {
+            initializeToDefaults(initialized, schema);
+            return initialized.size();
+        };
+    }
+}
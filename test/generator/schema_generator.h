@@ -0,0 +1,253 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// This header provides a generator for synthetic schemas and values
+// used by the scaling tests and benchmarks. The same options and seed
+// always produce the same schema and value, on every platform.
+//
+#ifndef IMJSCHEMA_SCHEMA_GENERATOR_H
+#define IMJSCHEMA_SCHEMA_GENERATOR_H
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace ImJSchema
+{
+namespace generator
+{
+using json = nlohmann::json;
+
+/**
+ * @brief The SchemaGeneratorOptions struct
+ *
+ * The shape of a generated schema. Every object has "breadth" properties
+ * plus "refFanOut" properties which reference one of the "$defs", and if
+ * oneOfCount is not zero, a property with oneOfCount alternatives.
+ * Objects above the last level also contain a nested object and an
+ * array of objects.
+ */
+struct SchemaGeneratorOptions
+{
+    uint32_t seed        = 1;
+    uint32_t depth       = 3;   // levels of nested objects
+    uint32_t breadth     = 4;   // leaf properties per object
+    uint32_t arrayLength = 8;   // minItems of the arrays
+    uint32_t enumCount   = 4;   // values of each enum
+    uint32_t defCount    = 2;   // number of entries in "$defs"
+    uint32_t refFanOut   = 1;   // "$ref" properties per object
+    uint32_t oneOfCount  = 0;   // alternatives of the "oneOf" property
+};
+
+namespace detail
+{
+
+/**
+ * @brief _pick
+ * @param rng
+ * @param n
+ * @return
+ *
+ * Returns a number in [0, n). The std distributions are implementation
+ * defined, but the output of std::mt19937 is not.
+ */
+inline uint32_t _pick(std::mt19937 & rng, uint32_t n)
+{
+    return n ? static_cast<uint32_t>(rng() % n) : 0u;
+}
+
+inline json _leafSchema(std::mt19937 & rng, SchemaGeneratorOptions const & opt)
+{
+    switch(_pick(rng, 7))
+    {
+        case 0:  return {{"type", "number"}, {"minimum", 0}, {"maximum", 100}};
+        case 1:  return {{"type", "number"}, {"minimum", 0}, {"maximum", 1}, {"ui:widget", "slider"}};
+        case 2:  return {{"type", "integer"}, {"minimum", -10}, {"maximum", 10}, {"ui:widget", "drag"}};
+        case 3:  return {{"type", "string"}, {"maxLength", 16}};
+        case 4:  return {{"type", "boolean"}};
+        case 5:
+        {
+            json E = json::array();
+            for(uint32_t i = 0; i < opt.enumCount; i++)
+                E.push_back("value" + std::to_string(i));
+            return {{"type", "string"}, {"enum", std::move(E)}};
+        }
+        default:
+            return {{"type", "array"}, {"ui:widget", "color"}, {"minItems", 4}, {"maxItems", 4},
+                    {"items", {{"type", "number"}, {"minimum", 0}, {"maximum", 1}}}};
+    }
+}
+
+inline json _objectSchema(std::mt19937 & rng, SchemaGeneratorOptions const & opt, uint32_t level)
+{
+    json P = json::object();
+    for(uint32_t i = 0; i < opt.breadth; i++)
+        P["p" + std::to_string(i)] = _leafSchema(rng, opt);
+
+    for(uint32_t i = 0; i < opt.refFanOut && opt.defCount; i++)
+        P["ref" + std::to_string(i)] = {{"$ref", "#/$defs/def" + std::to_string(_pick(rng, opt.defCount))}};
+
+    if(opt.oneOfCount)
+    {
+        json A = json::array();
+        for(uint32_t i = 0; i < opt.oneOfCount; i++)
+        {
+            auto name = "option" + std::to_string(i);
+            json AP = json::object();
+            AP["_type"] = {{"type", "string"}, {"enum", json::array({name})}, {"default", name}, {"ui:hidden", true}};
+            AP["value" + std::to_string(i)] = _leafSchema(rng, opt);
+            A.push_back({{"type", "object"}, {"title", name}, {"properties", std::move(AP)}});
+        }
+        P["choice"] = {{"type", "object"}, {"oneOf", std::move(A)}};
+    }
+
+    if(level + 1 < opt.depth)
+    {
+        P["child"] = _objectSchema(rng, opt, level + 1);
+        P["list"]  = {{"type", "array"}, {"minItems", opt.arrayLength},
+                      {"items", _objectSchema(rng, opt, level + 1)}};
+    }
+    return {{"type", "object"}, {"properties", std::move(P)}};
+}
+
+inline json const & _resolve(json const & root, json const & schema)
+{
+    auto it = schema.find("$ref");
+    if(it == schema.end() || !it->is_string())
+        return schema;
+    auto & ref = it->get_ref<json::string_t const&>();
+    return _resolve(root, root.at(json::json_pointer(ref.substr(1))));
+}
+
+inline json _value(std::mt19937 & rng, json const & root, json const & schemaOrRef, uint32_t arrayLength)
+{
+    auto & schema = _resolve(root, schemaOrRef);
+
+    if(auto e = schema.find("enum"); e != schema.end() && e->is_array() && !e->empty())
+        return e->at(_pick(rng, static_cast<uint32_t>(e->size())));
+
+    if(auto o = schema.find("oneOf"); o != schema.end() && o->is_array() && !o->empty())
+        return _value(rng, root, o->at(_pick(rng, static_cast<uint32_t>(o->size()))), arrayLength);
+
+    auto type = schema.value("type", std::string());
+    if(type == "object")
+    {
+        json V = json::object();
+        if(auto p = schema.find("properties"); p != schema.end())
+        {
+            for(auto & [name, s] : p->items())
+                V[name] = _value(rng, root, s, arrayLength);
+        }
+        return V;
+    }
+    if(type == "array")
+    {
+        json V = json::array();
+        auto n = schema.value("minItems", arrayLength);
+        if(auto it = schema.find("items"); it != schema.end())
+        {
+            for(uint32_t i = 0; i < n; i++)
+                V.push_back(_value(rng, root, *it, arrayLength));
+        }
+        return V;
+    }
+    if(type == "number" || type == "integer")
+    {
+        auto lo = schema.value("minimum", 0.0);
+        auto hi = schema.value("maximum", lo + 100.0);
+        auto x  = lo + (hi - lo) * static_cast<double>(_pick(rng, 1001)) / 1000.0;
+        if(type == "integer")
+            return static_cast<int64_t>(x);
+        return x;
+    }
+    if(type == "string")
+    {
+        std::string s;
+        auto n = std::min<uint32_t>(_pick(rng, 12) + 1, schema.value("maxLength", 16u));
+        for(uint32_t i = 0; i < n; i++)
+            s.push_back(static_cast<char>('a' + _pick(rng, 26)));
+        return s;
+    }
+    if(type == "boolean")
+        return _pick(rng, 2) == 1;
+    return nullptr;
+}
+
+}
+
+/**
+ * @brief generateSchema
+ * @param opt
+ * @return
+ *
+ * Generates a schema with the shape given by opt. The "$defs" are
+ * objects of the same shape with depth 1, the "$ref" to them are
+ * not expanded.
+ */
+inline json generateSchema(SchemaGeneratorOptions const & opt)
+{
+    std::mt19937 rng(opt.seed);
+
+    auto defOpt = opt;
+    defOpt.depth      = 1;
+    defOpt.refFanOut  = 0;
+    defOpt.oneOfCount = 0;
+
+    json defs = json::object();
+    for(uint32_t i = 0; i < opt.defCount; i++)
+        defs["def" + std::to_string(i)] = detail::_objectSchema(rng, defOpt, 0);
+
+    auto S = detail::_objectSchema(rng, opt, 0);
+    if(opt.defCount)
+        S["$defs"] = std::move(defs);
+    return S;
+}
+
+/**
+ * @brief generateValue
+ * @param schema
+ * @param seed
+ * @param arrayLength
+ * @return
+ *
+ * Generates a value which is valid for the schema: every property is
+ * set, enums and oneOf alternatives are picked at random, and arrays
+ * have minItems items (or arrayLength if there is no minItems). Local
+ * "$ref" (eg: "#/$defs/name") are followed, so the schema does not need
+ * to be expanded.
+ */
+inline json generateValue(json const & schema, uint32_t seed = 1, uint32_t arrayLength = 8)
+{
+    std::mt19937 rng(seed);
+    return detail::_value(rng, schema, schema, arrayLength);
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include <catch2/catch_all.hpp>
+
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include "ImJSchema/detail/json_utils.h"
+#include "ImJSchema/detail/profiler.h"
+
+#define IMJSCHEMA_IMPLEMENT_ALLOCATION_HOOKS
+#include "ImJSchema/detail/allocation_hooks.h"
+
+using namespace ImJSchema;
+
+TEST_CASE("threadAllocationStats - counts the calling thread")
+{
+    auto before = threadAllocationStats();
+    {
+        json J = json::array();
+        for(int i = 0; i < 4; i++)
+            J.push_back(std::string(64, 'x'));
+    }
+    auto after = threadAllocationStats() - before;
+    REQUIRE(after.count >= 5);
+    REQUIRE(after.bytes >= 4 * 64);
+
+    // allocations on another thread are not added to this one
+    before = threadAllocationStats();
+    AllocationStats other;
+    std::thread([&]()
+    {
+        auto b = threadAllocationStats();
+        std::string s(1024, 'x');
+        other = threadAllocationStats() - b;
+    }).join();
+    REQUIRE(other.count == 1);
+    REQUIRE(other.bytes >= 1024);
+    REQUIRE(threadAllocationStats().count - before.count < other.count + 8);
+}
+
+TEST_CASE("WidgetProfiler - allocations per widget")
+{
+    WidgetProfiler P;
+
+    for(int frame = 0; frame < 2; frame++)
+    {
+        P.beginWidget("object");
+        {
+            std::string s(128, 'x');
+
+            P.beginWidget("x");
+            P.endWidget("number", "");
+
+            P.beginWidget("name");
+            std::string t(256, 'y');
+            P.endWidget("string", "");
+        }
+        P.endWidget("object", "");
+        P.endFrame();
+    }
+
+    // the allocations made by the profiler itself are not counted
+    auto & paths = P.paths();
+    REQUIRE(paths.at("object/x").allocs.count == 0);
+    REQUIRE(paths.at("object/name").allocs.count == 2);
+    REQUIRE(paths.at("object/name").allocs.bytes >= 2 * 256);
+    REQUIRE(paths.at("object").allocs.count == 2);
+    REQUIRE(paths.at("object").allocs.bytes < 2 * 256);
+    REQUIRE(P.widgets().at("string/").allocs.count == 2);
+}
+
+TEST_CASE("initializeToDefaults - does not allocate once the defaults are set")
+{
+    // the defaults are applied to the value every frame when it is
+    // drawn without a FormState, once they are all set it should
+    // not allocate.
+    //
+    // The allocations of an entire frame need an ImGui context, they
+    // are checked against IMJSCHEMA_ALLOCATION_BUDGET by the
+    // test-allocation-budget test, see tools/CMakeLists.txt
+
+    for(auto & e : std::filesystem::directory_iterator(CMAKE_SOURCE_DIR "/share"))
+    {
+        if(e.path().extension() != ".json")
+            continue;
+
+        json schema;
+        REQUIRE(JsonDocumentCache::loadFile(e.path().string(), schema));
+        JsonDocumentCache documents;
+        jsonExpandAllReferences(schema, documents, e.path().string());
+
+        json value;
+        initializeToDefaults(value, schema);
+
+        auto before = threadAllocationStats();
+        initializeToDefaults(value, schema);
+        auto frame = threadAllocationStats() - before;
+
+        INFO(e.path().filename().string());
+        REQUIRE(frame.count == 0);
+    }
+}
+
+TEST_CASE("JsonSchemaIndex - lookups do not allocate")
+{
+    auto J = json::parse(R"foo(
+    {
+        "$defs" : {
+            "aVeryLongDefinitionNameWhichIsNotInTheSmallStringBuffer" : { "type" : "number" }
+        }
+    })foo");
+
+    JsonSchemaIndex index(J);
+    std::string_view ref = "#/$defs/aVeryLongDefinitionNameWhichIsNotInTheSmallStringBuffer";
+    auto expected = &J["$defs"]["aVeryLongDefinitionNameWhichIsNotInTheSmallStringBuffer"];
+    REQUIRE(index.find(ref) == expected);
+
+    auto before = threadAllocationStats();
+    for(int i = 0; i < 10; i++)
+    {
+        REQUIRE(index.find(ref) == expected);
+        REQUIRE(index.contains(ref));
+    }
+    REQUIRE((threadAllocationStats() - before).count == 0);
+}
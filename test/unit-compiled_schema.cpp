@@ -0,0 +1,450 @@
+#include <catch2/catch_all.hpp>
+
+#include "ImJSchema/detail/compiled_schema.h"
+#include "ImJSchema/detail/widget_path.h"
+#include "ImJSchema/detail/widget_state.h"
+
+TEST_CASE("compileSchema - nodes and properties")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "title" : "Root",
+        "ui:order" : ["c", "a"],
+        "required" : ["a"],
+        "properties" : {
+            "a" : { "type" : "number", "minimum" : 1, "maximum" : 10.5, "ui:widget" : "slider" },
+            "b" : { "type" : "string", "ui:hidden" : true },
+            "c" : { "type" : "array", "minItems" : 2, "items" : { "type" : "integer" } },
+            "d" : { "description" : "no type, is not drawn" }
+        }
+    })foo");
+
+    detail::WidgetRegistry widgets;
+    widgets["object/"]       = [](WidgetDrawInput&){ return false; };
+    widgets["number/slider"] = [](WidgetDrawInput&){ return false; };
+
+    auto C = compileSchema(schema, widgets);
+
+    // root, a, b, c, c.items
+    REQUIRE(C.nodes.size() == 5);
+
+    auto & root = C.root();
+    REQUIRE(root.type == SchemaType::Object);
+    REQUIRE(std::string(root.title) == "Root");
+    REQUIRE(&widgets.get(root.widget) == &widgets["object/"]);
+    REQUIRE(root.showAddProperty);
+    REQUIRE(root.propertyCount == 3);
+
+    // ui:order is applied
+    auto P = C.properties.begin() + root.firstProperty;
+    REQUIRE(*P[0].name == "c");
+    REQUIRE(*P[1].name == "a");
+    REQUIRE(*P[2].name == "b");
+
+    REQUIRE(P[0].required == false);
+    REQUIRE(P[1].required == true);
+    REQUIRE(P[2].required == false);
+
+    auto & a = C[P[1].node];
+    REQUIRE(a.type == SchemaType::Number);
+    REQUIRE(&widgets.get(a.widget) == &widgets["number/slider"]);
+    REQUIRE(a.getMinimum<double>() == 1.0);
+    REQUIRE(a.getMaximum<double>() == 10.5);
+    REQUIRE(a.getMinimum<int64_t>() == 1);
+    REQUIRE(a.getMaximum<int64_t>() == 10);
+
+    auto & b = C[P[2].node];
+    REQUIRE(b.hidden);
+    REQUIRE(!widgets.get(b.widget));
+    REQUIRE(b.getMinimum<int64_t>() == std::numeric_limits<int64_t>::lowest());
+
+    auto & c = C[P[0].node];
+    REQUIRE(c.type == SchemaType::Array);
+    REQUIRE(c.minItems == 2);
+    REQUIRE(c.items != CompiledNode::npos);
+    REQUIRE(C[c.items].type == SchemaType::Integer);
+}
+
+TEST_CASE("compileSchema - oneOf")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "oneOf" : [
+            { "type" : "object", "title" : "Sphere", "properties" : { "radius" : { "type" : "number" } } },
+            { "type" : "object", "title" : "Box",    "properties" : { "length" : { "type" : "number" } } }
+        ]
+    })foo");
+
+    detail::WidgetRegistry widgets;
+    auto C = compileSchema(schema, widgets);
+
+    auto & root = C.root();
+    REQUIRE(root.alternativeCount == 2);
+    REQUIRE(std::string(C[C.alternatives[root.firstAlternative+0]].title) == "Sphere");
+    REQUIRE(std::string(C[C.alternatives[root.firstAlternative+1]].title) == "Box");
+
+    // copies share the same source, so the node pointers stay valid
+    auto C2 = C;
+    REQUIRE(C2.root().schema == C.source.get());
+}
+
+TEST_CASE("compileSchema - lazy references")
+{
+    using namespace ImJSchema;
+
+    // a recursive schema can not be expanded, but can be drawn
+    // if the references are resolved when they are opened
+    auto schema = json::parse(R"foo(
+    {
+        "$defs" : {
+            "node" : {
+                "type" : "object",
+                "properties" : {
+                    "name" : { "type" : "string" },
+                    "children" : { "type" : "array", "items" : { "$ref" : "#/$defs/node" } }
+                }
+            },
+            "kinds" : ["leaf", "branch"]
+        },
+        "type" : "object",
+        "ui:order" : ["tree", "kind"],
+        "properties" : {
+            "tree" : { "$ref" : "#/$defs/node", "title" : "Tree" },
+            "kind" : { "type" : "string", "enum" : { "$ref" : "#/$defs/kinds" } }
+        }
+    })foo");
+
+    auto expanded = schema;
+    REQUIRE_THROWS(jsonExpandAllReferences(expanded));
+
+    detail::WidgetRegistry widgets;
+    auto C = compileSchema(schema, widgets, true);
+
+    // root, tree, kind
+    REQUIRE(C.nodes.size() == 3);
+    REQUIRE(C.root().propertyCount == 2);
+
+    auto P = C.properties.begin() + C.root().firstProperty;
+    auto & tree = C[P[0].node];
+    REQUIRE(tree.isRef);
+    REQUIRE(!tree.resolved);
+
+    // references used as keyword values are expanded
+    REQUIRE(C[P[1].node].schema->at("enum") == json({"leaf", "branch"}));
+
+    auto [TS, t] = detail::resolveNode(C, P[0].node);
+    REQUIRE(tree.resolved);
+    REQUIRE(TS->nodes[t].type == SchemaType::Object);
+    REQUIRE(std::string(TS->nodes[t].title) == "Tree");
+    REQUIRE(detail::resolveNode(C, P[0].node).first == TS);
+
+    // the children are not resolved until they are drawn
+    auto & children = TS->nodes[TS->properties[TS->nodes[t].firstProperty + 0].node];
+    REQUIRE(children.type == SchemaType::Array);
+    REQUIRE(TS->nodes[children.items].isRef);
+    REQUIRE(!TS->nodes[children.items].resolved);
+
+    auto [CS, c] = detail::resolveNode(*TS, children.items);
+    REQUIRE(CS->nodes[c].type == SchemaType::Object);
+    REQUIRE(CS->nodes[c].propertyCount == 2);
+}
+
+TEST_CASE("compileSchema - lazy references are compiled once")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "$defs" : {
+            "a"   : { "$ref" : "#/$defs/b" },
+            "b"   : { "$ref" : "#/$defs/a" },
+            "num" : { "type" : "number" }
+        },
+        "type" : "object",
+        "properties" : {
+            "loop" : { "$ref" : "#/$defs/a" },
+            "x"    : { "$ref" : "#/$defs/num", "ui:widget" : "slider" },
+            "y"    : { "$ref" : "#/$defs/num", "ui:widget" : "slider" },
+            "z"    : { "$ref" : "#/$defs/num" }
+        }
+    })foo");
+
+    detail::WidgetRegistry widgets;
+    auto C = compileSchema(schema, widgets, true);
+
+    // the ui:widget of the reference is merged with the type of the
+    // definition, the pair is interned before anything is drawn
+    auto sliderId = widgets.findId("number", "slider");
+    REQUIRE(sliderId != detail::WidgetRegistry::npos);
+
+    auto P = C.properties.begin() + C.root().firstProperty;
+    REQUIRE(C.root().propertyCount == 4);
+
+    // circular references are reported instead of thrown
+    detail::resolveNode(C, P[0].node);
+    auto [LS, l] = detail::resolveNode(C, P[0].node);
+    REQUIRE(!LS->error.empty());
+    REQUIRE(LS->nodes[l].type == SchemaType::Unknown);
+
+    // the same reference is only compiled once
+    auto [XS, x] = detail::resolveNode(C, P[1].node);
+    auto [YS, y] = detail::resolveNode(C, P[2].node);
+    auto [ZS, z] = detail::resolveNode(C, P[3].node);
+    REQUIRE(XS->error.empty());
+    REQUIRE(XS == YS);
+    REQUIRE(XS != ZS);
+    REQUIRE(XS->nodes[x].widget == sliderId);
+    REQUIRE(ZS->nodes[z].widget == widgets.findId("number", ""));
+    REQUIRE(&detail::defaultInstance(C, P[1].node) == &detail::defaultInstance(C, P[2].node));
+
+    // the copies share the compiled references
+    auto C2 = C;
+    REQUIRE(detail::resolveNode(C2, P[1].node).first == XS);
+}
+
+TEST_CASE("compileSchema - default instances")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "$defs" : {
+            "point" : {
+                "type" : "object",
+                "properties" : {
+                    "x" : { "type" : "number", "default" : 1.5 },
+                    "tags" : { "type" : "array", "minItems" : 2, "items" : { "type" : "string", "default" : "t" } }
+                }
+            }
+        },
+        "type" : "object",
+        "properties" : {
+            "points" : { "type" : "array", "minItems" : 3, "items" : { "$ref" : "#/$defs/point" } }
+        }
+    })foo");
+
+    detail::WidgetRegistry widgets;
+    auto C = compileSchema(schema, widgets, true);
+
+    auto P = C.properties.begin() + C.root().firstProperty;
+    auto & points = C[P[0].node];
+
+    auto & item = detail::defaultInstance(C, points.items);
+    REQUIRE(item == json::parse(R"({ "x" : 1.5, "tags" : ["t", "t"] })"));
+
+    // the default is created once and kept in the resolved node
+    REQUIRE(&detail::defaultInstance(C, points.items) == &item);
+    REQUIRE(!C[points.items].defaultValue);
+
+    // the same value initializeToDefaults( ) creates
+    REQUIRE(detail::defaultInstance(C, 0) == defaultInstance(*C.root().schema));
+    REQUIRE(detail::defaultInstance(C, 0)["points"].size() == 3);
+}
+
+TEST_CASE("WidgetRegistry")
+{
+    using namespace ImJSchema;
+
+    detail::WidgetRegistry widgets{
+        {"number/", [](WidgetDrawInput&){ return false; }},
+        {"number/slider", [](WidgetDrawInput&){ return true; }}
+    };
+
+    REQUIRE(widgets.lookup("number", "") != nullptr);
+    REQUIRE(widgets.lookup("number", "slider") == &widgets.find("number/slider")->second);
+    REQUIRE(widgets.lookup("number", "drag") == nullptr);
+    REQUIRE(widgets.lookup("string", "") == nullptr);
+
+    // ids are stable and can be resolved before the
+    // widget is registered
+    auto id = widgets.intern("number", "my_custom_number_widget");
+    REQUIRE(id == widgets.intern("number/my_custom_number_widget"));
+    REQUIRE(!widgets.get(id));
+    REQUIRE(!widgets.get(detail::WidgetRegistry::npos));
+    REQUIRE(widgets.lookup("number", "my_custom_number_widget") == nullptr);
+
+    widgets["number/my_custom_number_widget"] = [](WidgetDrawInput&){ return true; };
+    REQUIRE(widgets.get(id));
+    REQUIRE(widgets.lookup("number", "my_custom_number_widget") == &widgets.get(id));
+}
+
+TEST_CASE("WidgetRegistry - std::map interface")
+{
+    using namespace ImJSchema;
+
+    detail::WidgetRegistry widgets{
+        {"number/", [](WidgetDrawInput&){ return false; }},
+        {"number/slider", [](WidgetDrawInput&){ return true; }}
+    };
+
+    // interned ids without a draw function are not listed
+    widgets.intern("string", "");
+    REQUIRE(widgets.size() == 2);
+    REQUIRE(widgets.count("number/slider") == 1);
+    REQUIRE(widgets.count("string/") == 0);
+    REQUIRE(widgets.find("string/") == widgets.end());
+    REQUIRE(widgets.find("number/slider")->first == "number/slider");
+
+    std::vector<std::string> keys;
+    for(auto & [key, func] : widgets)
+    {
+        REQUIRE(func);
+        keys.push_back(key);
+    }
+    REQUIRE(keys == std::vector<std::string>{"number/", "number/slider"});
+
+    detail::WidgetRegistry const & C = widgets;
+    detail::WidgetRegistry::const_iterator it = widgets.begin();
+    REQUIRE(it == C.begin());
+    REQUIRE(C.find("number/") != C.end());
+
+    REQUIRE(widgets.erase("number/slider") == 1);
+    REQUIRE(widgets.erase("number/slider") == 0);
+    REQUIRE(widgets.count("number/slider") == 0);
+    REQUIRE(widgets.size() == 1);
+}
+
+TEST_CASE("WidgetPath")
+{
+    using namespace ImJSchema;
+
+    detail::WidgetPath path;
+    path.push("object");
+    path.push("position");
+    path.push("a/b");
+
+    REQUIRE(path.size() == 3);
+    REQUIRE(path[1] == "position");
+    REQUIRE(path.toPointer(1) == json::json_pointer("/position/a~1b"));
+
+    path.pop();
+    path.push("x");
+    REQUIRE(path.toPointer() == json::json_pointer("/object/position/x"));
+
+    path.truncate(1);
+    REQUIRE(path.size() == 1);
+    REQUIRE(path.toPointer() == json::json_pointer("/object"));
+
+    path.clear();
+    path.pop();
+    REQUIRE(path.size() == 0);
+}
+
+TEST_CASE("WidgetState")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "properties" : {
+            "a" : { "type" : "string", "enum" : ["x", "y"] },
+            "b" : { "type" : "array", "items" : { "type" : "number" } }
+        }
+    })foo");
+
+    detail::WidgetRegistry widgets;
+    auto C = compileSchema(schema, widgets);
+
+    detail::WidgetStateArena arena(8);
+    detail::WidgetState root;
+
+    auto & a = root.property(arena, C, 0, 0);
+    auto & b = root.property(arena, C, 0, 1);
+    REQUIRE(&b == &a + 1);
+    REQUIRE(&root.property(arena, C, 0, 0) == &a);
+
+    a.enumIndex = 1;
+    b.item(arena, 0).cache = 0;
+    b.item(arena, 1).cache = 1;
+    b.item(arena, 2).cache = 2;
+    b.item(arena, 9).cache = 9;
+    REQUIRE(b.childCount == 10);
+
+    // item states are moved when the array grows
+    REQUIRE(b.children[2].cache == 2);
+
+    b.swapItems(0, 2);
+    b.eraseItem(arena, 1);
+    REQUIRE(b.childCount == 9);
+    REQUIRE(b.children[0].cache == 2);
+    REQUIRE(b.children[1].cache == 0);
+    REQUIRE(b.children[8].cache == 9);
+
+    a.disabled = true;
+    auto J = detail::widgetStateToJson(C, 0, root);
+    REQUIRE(J["a"]["enumIndex"] == 1);
+    REQUIRE(J["b"].size() == 9);
+    REQUIRE(J["optional_items"]["a"] == true);
+
+    root.reset();
+    arena.clear();
+    REQUIRE(root.childCount == 0);
+    REQUIRE(arena.capacity() == 0);
+}
+
+TEST_CASE("WidgetState - switching oneOf reuses the arena")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "oneOf" : [
+            { "type" : "object", "properties" : { "radius" : { "type" : "number" } } },
+            { "type" : "object", "properties" : {
+                    "size"   : { "type" : "number" },
+                    "points" : { "type" : "array", "items" : { "type" : "object", "properties" : { "x" : { "type" : "number" } } } }
+                }
+            }
+        ]
+    })foo");
+
+    detail::WidgetRegistry widgets;
+    auto C = compileSchema(schema, widgets);
+    auto & root = C.root();
+    auto sphere = C.alternatives[root.firstAlternative+0];
+    auto box    = C.alternatives[root.firstAlternative+1];
+    REQUIRE(C.nodes[sphere].propertyCount == 1);
+    REQUIRE(C.nodes[box].propertyCount == 2);
+
+    uint32_t pointsIndex = 0;
+    while(*C.properties[C.nodes[box].firstProperty + pointsIndex].name != "points")
+        pointsIndex++;
+    auto pointNode = C.nodes[C.properties[C.nodes[box].firstProperty + pointsIndex].node].items;
+
+    detail::WidgetStateArena arena(16);
+    detail::WidgetState state;
+
+    auto _switch = [&]()
+    {
+        state.property(arena, C, sphere, 0).cache = 1.0;
+
+        auto & points = state.property(arena, C, box, pointsIndex);
+        for(size_t i = 0; i < 20; i++)
+            points.item(arena, i).property(arena, C, pointNode, 0);
+        points.eraseItem(arena, 3);
+    };
+
+    _switch();
+    auto capacity = arena.capacity();
+    auto used     = arena.used();
+
+    for(int i = 0; i < 100; i++)
+        _switch();
+
+    REQUIRE(arena.capacity() == capacity);
+    REQUIRE(arena.used() == used);
+
+    // the states handed out again are default constructed
+    REQUIRE(state.property(arena, C, sphere, 0).cache.is_null());
+
+    state.reset(arena);
+    REQUIRE(arena.used() == 0);
+}
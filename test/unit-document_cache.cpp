@@ -0,0 +1,192 @@
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "ImJSchema/detail/json_utils.h"
+
+TEST_CASE("JsonDocumentCache - resolveUri")
+{
+    using namespace ImJSchema;
+
+    REQUIRE(JsonDocumentCache::resolveUri("", "common/material.json") == "common/material.json");
+    REQUIRE(JsonDocumentCache::resolveUri("schemas/scene.json", "material.json") == "schemas/material.json");
+    REQUIRE(JsonDocumentCache::resolveUri("schemas/scene.json", "../common/./material.json") == "common/material.json");
+    REQUIRE(JsonDocumentCache::resolveUri("schemas/scene.json", "/abs/material.json") == "/abs/material.json");
+    REQUIRE(JsonDocumentCache::resolveUri("http://host/a/scene.json", "../b.json") == "http://host/b.json");
+    REQUIRE(JsonDocumentCache::resolveUri("scene.json", "../b.json") == "../b.json");
+}
+
+TEST_CASE("JsonDocumentCache - files are loaded once")
+{
+    using namespace ImJSchema;
+
+    auto dir = std::filesystem::temp_directory_path() / "imjschema-document-cache";
+    std::filesystem::create_directories(dir / "common");
+
+    std::ofstream(dir / "common" / "material.json") << R"foo(
+    {
+        "$defs" : {
+            "color" : { "type" : "array", "ui:widget" : "color", "items" : { "$ref" : "#/$defs/channel" } },
+            "channel" : { "$ref" : "types.json#/$defs/normalized" }
+        }
+    })foo";
+    std::ofstream(dir / "common" / "types.json") << R"foo(
+    {
+        "$defs" : {
+            "normalized" : { "type" : "number", "minimum" : 0, "maximum" : 1 }
+        }
+    })foo";
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "properties" : {
+            "albedo"   : { "$ref" : "common/material.json#/$defs/color", "title" : "Albedo" },
+            "emissive" : { "$ref" : "common/material.json#/$defs/color" },
+            "missing"  : { "$ref" : "common/missing.json#/$defs/color", "type" : "string" }
+        }
+    })foo");
+
+    JsonDocumentCache documents;
+    auto root = (dir / "scene.json").string();
+    jsonExpandAllReferences(schema, documents, root);
+
+    auto & albedo = schema["properties"]["albedo"];
+    REQUIRE(albedo["title"] == "Albedo");
+    REQUIRE(albedo["ui:widget"] == "color");
+    REQUIRE(albedo["items"]["type"] == "number");
+    REQUIRE(albedo["items"]["maximum"] == 1);
+    REQUIRE(!albedo["items"].contains("$ref"));
+    REQUIRE(schema["properties"]["emissive"]["items"] == albedo["items"]);
+    REQUIRE(schema["properties"]["missing"]["type"] == "string");
+
+    // material.json, types.json and the missing file
+    REQUIRE(documents.size() == 3);
+    REQUIRE(documents.load((dir / "common" / "missing.json").string()) == nullptr);
+    auto material = documents.load((dir / "common" / "material.json").string());
+    REQUIRE(material != nullptr);
+    REQUIRE(material == documents.load((dir / "common" / "material.json").string()));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("JsonDocumentCache - custom loader")
+{
+    using namespace ImJSchema;
+
+    size_t loads = 0;
+    JsonDocumentCache documents([&](std::string const & uri, json & document)
+    {
+        loads++;
+        if(uri != "mem://defs.json")
+            return false;
+        document = json::parse(R"foo({ "$defs" : { "name" : { "type" : "string", "default" : "bob" } } })foo");
+        return true;
+    });
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "properties" : {
+            "a" : { "$ref" : "defs.json#/$defs/name" },
+            "b" : { "$ref" : "defs.json#/$defs/name" }
+        }
+    })foo");
+
+    jsonExpandAllReferences(schema, documents, "mem://schema.json");
+    REQUIRE(schema["properties"]["a"]["default"] == "bob");
+    REQUIRE(schema["properties"]["b"]["default"] == "bob");
+    REQUIRE(loads == 1);
+}
+
+TEST_CASE("JsonDocumentCache - loaders can use the cache")
+{
+    using namespace ImJSchema;
+
+    // the loader is called without holding the lock, so
+    // it can load the documents it depends on
+    JsonDocumentCache documents;
+    std::atomic<size_t> loads{0};
+    std::atomic<bool>   reentered{false};
+    documents.setLoader([&](std::string const & uri, json & document)
+    {
+        loads++;
+        if(uri == "mem://a.json")
+        {
+            auto b = documents.load("mem://b.json");
+            document = { {"b", b ? *b : json()} };
+            return true;
+        }
+        if(uri == "mem://b.json")
+        {
+            // loading the document being loaded does not deadlock
+            reentered = documents.load("mem://b.json") == nullptr;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            document = 2;
+            return true;
+        }
+        return false;
+    });
+
+    std::vector<std::thread> threads;
+    std::vector<std::shared_ptr<json const>> results(4);
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            results[i] = documents.load("mem://a.json");
+        });
+    }
+    for(auto & t : threads)
+        t.join();
+
+    REQUIRE(reentered);
+    for(auto & a : results)
+    {
+        REQUIRE(a != nullptr);
+        REQUIRE(a == results[0]);
+        REQUIRE(a->at("b") == 2);
+    }
+
+    // each document is only loaded once
+    REQUIRE(loads == 2);
+    REQUIRE(documents.size() == 2);
+}
+
+TEST_CASE("JsonDocumentCache - documents which need each other on two threads")
+{
+    using namespace ImJSchema;
+
+    // a.json needs b.json and b.json needs a.json. Each is started on
+    // its own thread, so each thread waits for the document the other
+    // one is loading. The second one to wait gets nullptr instead of
+    // waiting, so the cycle is broken
+    JsonDocumentCache documents;
+    std::atomic<int> started{0};
+    documents.setLoader([&](std::string const & uri, json & document)
+    {
+        started++;
+        while(started < 2)
+            std::this_thread::yield();
+
+        auto other = documents.load(uri == "mem://a.json" ? "mem://b.json" : "mem://a.json");
+        document = { {"other", other ? *other : json()} };
+        return true;
+    });
+
+    std::shared_ptr<json const> a, b;
+    std::thread ta([&](){ a = documents.load("mem://a.json"); });
+    std::thread tb([&](){ b = documents.load("mem://b.json"); });
+    ta.join();
+    tb.join();
+
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+
+    // one of them was loaded without the other
+    REQUIRE(a->at("other").is_null() != b->at("other").is_null());
+    REQUIRE(documents.size() == 2);
+}
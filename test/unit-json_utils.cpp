@@ -1,5 +1,7 @@
 #include <catch2/catch_all.hpp>
 
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 #include "ImJSchema/detail/json_utils.h"
@@ -44,6 +46,39 @@ TEST_CASE("jsonFindPath")
     }
 }
 
+TEST_CASE("jsonFindPath - json pointer")
+{
+    using namespace ImJSchema;
+    json J;
+    J["$defs"]["a/b"]["m~n"] = 1;
+    J["$defs"]["list"] = {10, 11, 12};
+
+    REQUIRE(jsonFindPath("#/$defs/a~1b/m~0n", J) == &J["$defs"]["a/b"]["m~n"]);
+    REQUIRE(jsonFindPath("/$defs/list/2", J) == &J["$defs"]["list"][2]);
+    REQUIRE(jsonFindPath("", J) == &J);
+    REQUIRE(jsonFindPath("#", J) == &J);
+
+    // not valid array indices
+    REQUIRE(jsonFindPath("$defs/list/01", J) == nullptr);
+    REQUIRE(jsonFindPath("$defs/list/1x", J) == nullptr);
+    REQUIRE(jsonFindPath("$defs/list/-", J) == nullptr);
+
+    CompiledPath path("#/$defs/a~1b/m~0n");
+    REQUIRE(path.size() == 3);
+    REQUIRE(path[1].key == "a/b");
+    REQUIRE(path[2].key == "m~n");
+    REQUIRE(path[2].index == CompiledPath::npos);
+    REQUIRE(jsonFindPath(path, J) == &J["$defs"]["a/b"]["m~n"]);
+    REQUIRE(CompiledPath("list/2")[1].index == 2);
+
+    json const & cJ = J;
+    JsonPathCache cache(cJ);
+    REQUIRE(cache.find("$defs/list/0") == &cJ["$defs"]["list"][0]);
+    REQUIRE(cache.find("$defs/missing") == nullptr);
+    REQUIRE(cache.find("$defs/list/0") == &cJ["$defs"]["list"][0]);
+    REQUIRE(cache.size() == 2);
+}
+
 TEST_CASE("json merge patch")
 {
     using namespace ImJSchema;
@@ -288,3 +323,237 @@ TEST_CASE("setDefaultsRecursive")
     REQUIRE(value.dump() == v2.dump());
     REQUIRE(value.dump() != DEFAULTS.dump());
 }
+
+TEST_CASE("jsonExpandAllReferences - definitions are resolved once")
+{
+    using namespace ImJSchema;
+
+    auto J = json::parse(R"foo(
+    {
+        "$defs" : {
+            "vec3" : {
+                "type" : "array",
+                "items" : { "$ref" : "#/$defs/number" }
+            },
+            "number" : { "type" : "number" }
+        },
+        "type" : "object",
+        "properties" : {
+            "position" : { "$ref" : "#/$defs/vec3" },
+            "velocity" : { "$ref" : "#/$defs/vec3", "title" : "Velocity" },
+            "mass"     : { "$ref" : "#/$defs/number" }
+        }
+    })foo");
+
+    JsonRefStats stats;
+    jsonExpandAllReferences(J, J, stats);
+
+    REQUIRE(J["properties"]["velocity"]["title"] == "Velocity");
+    REQUIRE(J["properties"]["velocity"]["items"]["type"] == "number");
+    REQUIRE(J["properties"]["position"] == J["$defs"]["vec3"]);
+
+    // vec3 and number are only resolved once
+    REQUIRE(stats.definitions == 2);
+    REQUIRE(stats.cacheHits > 0);
+}
+
+TEST_CASE("jsonExpandAllReferences - circular references throw")
+{
+    using namespace ImJSchema;
+
+    auto J = json::parse(R"foo(
+    {
+        "$defs" : {
+            "node" : {
+                "type" : "object",
+                "properties" : {
+                    "child" : { "$ref" : "#/$defs/node" }
+                }
+            }
+        },
+        "$ref" : "#/$defs/node"
+    })foo");
+
+    REQUIRE_THROWS_AS(jsonExpandAllReferences(J), std::runtime_error);
+
+    auto K = json::parse(R"foo(
+    {
+        "$defs" : {
+            "A" : { "$ref" : "#/$defs/B" },
+            "B" : { "$ref" : "#/$defs/A" }
+        },
+        "value" : { "$ref" : "#/$defs/A" }
+    })foo");
+
+    REQUIRE_THROWS_AS(jsonExpandAllReferences(K), std::runtime_error);
+}
+
+TEST_CASE("jsonExpandAllReferencesParallel matches the serial expansion")
+{
+    using namespace ImJSchema;
+
+    std::vector<json> schemas;
+    for(auto & e : std::filesystem::directory_iterator(CMAKE_SOURCE_DIR "/share"))
+    {
+        if(e.path().extension() != ".json")
+            continue;
+        std::ifstream in(e.path());
+        schemas.push_back(json::parse(in));
+    }
+    REQUIRE(!schemas.empty());
+
+    // a large document with many references to the same definitions
+    json large;
+    large["$defs"]["vec3"] = { {"type", "array"}, {"items", { {"$ref", "#/$defs/number"} }} };
+    large["$defs"]["number"] = { {"type", "number"}, {"default", 1.0} };
+    large["type"] = "object";
+    for(int i = 0; i < 500; i++)
+    {
+        auto & p = large["properties"]["p" + std::to_string(i)];
+        p["type"] = "object";
+        p["properties"]["position"]["$ref"] = "#/$defs/vec3";
+        p["properties"]["scale"]["$ref"] = json::array({"#/$defs/number", "#/$defs/vec3"});
+    }
+    schemas.push_back(large);
+
+    for(auto & schema : schemas)
+    {
+        auto serial = schema;
+        jsonExpandAllReferences(serial);
+
+        for(size_t threads : {1u, 2u, 4u, 7u})
+        {
+            auto parallel = schema;
+            jsonExpandAllReferencesParallel(parallel, threads);
+            REQUIRE(parallel == serial);
+        }
+    }
+
+    json circular;
+    circular["$defs"]["A"]["$ref"] = "#/$defs/A";
+    for(int i = 0; i < 100; i++)
+        circular["properties"]["p" + std::to_string(i)]["$ref"] = "#/$defs/A";
+    REQUIRE_THROWS_AS(jsonExpandAllReferencesParallel(circular, 4), std::runtime_error);
+}
+
+TEST_CASE("JsonSchemaIndex")
+{
+    using namespace ImJSchema;
+
+    auto J = json::parse(R"foo(
+    {
+        "$defs" : {
+            "a/b" : { "type" : "number" },
+            "named" : { "$anchor" : "color", "type" : "array" }
+        },
+        "properties" : {
+            "item" : {
+                "$id" : "item.json",
+                "$defs" : { "inner" : { "type" : "string" } },
+                "properties" : {
+                    "x" : { "$anchor" : "x", "type" : "integer" }
+                }
+            }
+        }
+    })foo");
+
+    JsonSchemaIndex index(J);
+
+    REQUIRE(index.contains("#/$defs/a~1b"));
+    REQUIRE(index.find("#/$defs/a~1b") == &J["$defs"]["a/b"]);
+    REQUIRE(index.find("#color") == &J["$defs"]["named"]);
+    REQUIRE(index.find("item.json") == &J["properties"]["item"]);
+
+    // the pointers within an $id are relative to it
+    REQUIRE(index.find("item.json#/$defs/inner") == &J["properties"]["item"]["$defs"]["inner"]);
+    REQUIRE(index.find("item.json#x") == &J["properties"]["item"]["properties"]["x"]);
+
+    // json pointers which are not indexed are still found
+    REQUIRE(!index.contains("#/properties/item/properties"));
+    REQUIRE(index.find("#/properties/item/properties") == &J["properties"]["item"]["properties"]);
+    REQUIRE(index.find("item.json#/properties/x") == &J["properties"]["item"]["properties"]["x"]);
+    REQUIRE(index.find("#missing") == nullptr);
+    REQUIRE(index.find("other.json#/a") == nullptr);
+
+    // references can use the anchors and ids
+    auto schema = J;
+    schema["properties"]["c"]["$ref"] = "#color";
+    schema["properties"]["d"]["$ref"] = "item.json#/$defs/inner";
+    jsonExpandAllReferences(schema);
+    REQUIRE(schema["properties"]["c"]["type"] == "array");
+    REQUIRE(schema["properties"]["d"]["type"] == "string");
+}
+
+TEST_CASE("initializeToDefaults - arrays of numbers")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "array",
+        "minItems" : 4,
+        "items" : { "type" : "integer", "default" : 7, "minimum" : 0, "maximum" : 10 }
+    })foo");
+
+    json value = json::array({1, "x", 2.5});
+    initializeToDefaults(value, schema);
+    REQUIRE(value == json::array({1, 7, 7, 7}));
+
+    // out of range values are not changed by initializeToDefaults,
+    // use clampNumericArray( ) to clamp them
+    value = json::array({-5, 3, 15, "x"});
+    initializeToDefaults(value, schema);
+    REQUIRE(value == json::array({-5, 3, 15, 7}));
+    REQUIRE(clampNumericArray(value, schema["items"]) == 2);
+    REQUIRE(value == json::array({0, 3, 10, 7}));
+    REQUIRE(value[2].is_number_integer());
+
+    json floats = json::array({-1.0, 0.5, 2.0, "y"});
+    REQUIRE(clampNumericArray(floats, json::parse(R"({ "type" : "number", "minimum" : 0, "exclusiveMaximum" : 1 })")) == 2);
+    REQUIRE(floats[0] == 0.0);
+    REQUIRE(floats[1] == 0.5);
+    REQUIRE(floats[2].get<double>() < 1.0);
+    REQUIRE(floats[3] == "y");
+}
+
+TEST_CASE("initializeToDefaultsParallel - large minItems")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "properties" : {
+            "samples" : {
+                "type" : "array",
+                "minItems" : 20000,
+                "items" : {
+                    "type" : "object",
+                    "properties" : {
+                        "name"  : { "type" : "string", "default" : "s" },
+                        "value" : { "type" : "number" }
+                    }
+                }
+            },
+            "grid" : { "type" : "array", "minItems" : 5000, "items" : { "type" : "string", "default" : "." } }
+        }
+    })foo");
+
+    json serial;
+    initializeToDefaults(serial, schema);
+    REQUIRE(serial["samples"].size() == 20000);
+    REQUIRE(serial["samples"][19999] == json::parse(R"({ "name" : "s", "value" : 0.0 })"));
+
+    json parallel;
+    initializeToDefaultsParallel(parallel, schema, 4);
+    REQUIRE(parallel == serial);
+
+    // existing items are kept
+    parallel = json::object();
+    parallel["samples"] = json::array({ json{{"name", "first"}}, 3 });
+    initializeToDefaultsParallel(parallel, schema, 4);
+    REQUIRE(parallel["samples"].size() == 20000);
+    REQUIRE(parallel["samples"][0] == json::parse(R"({ "name" : "first", "value" : 0.0 })"));
+    REQUIRE(parallel["samples"][1] == serial["samples"][1]);
+    REQUIRE(parallel["grid"] == serial["grid"]);
+}
@@ -0,0 +1,85 @@
+#include <catch2/catch_all.hpp>
+
+#include "ImJSchema/detail/profiler.h"
+
+TEST_CASE("WidgetProfiler - paths and widgets")
+{
+    using namespace ImJSchema;
+
+    WidgetProfiler P;
+
+    P.beginWidget("object");
+    for(int i = 0; i < 3; i++)
+    {
+        P.beginWidget("x");
+        P.endWidget("number", "slider");
+    }
+    P.beginWidget("points");
+    P.beginWidget("0");
+    P.endWidget("number", "");
+    P.endWidget("array", "");
+    P.endWidget("object", "");
+
+    // nothing is recorded until the end of the frame
+    REQUIRE(P.paths().empty());
+    P.endFrame();
+    REQUIRE(P.frameCount() == 1);
+
+    auto & paths = P.paths();
+    REQUIRE(paths.size() == 4);
+    REQUIRE(paths.at("object").calls == 1);
+    REQUIRE(paths.at("object/x").calls == 3);
+    REQUIRE(paths.at("object/points").calls == 1);
+    REQUIRE(paths.at("object/points/0").calls == 1);
+
+    auto & widgets = P.widgets();
+    REQUIRE(widgets.at("number/slider").calls == 3);
+    REQUIRE(widgets.at("number/").calls == 1);
+
+    // the self time of a widget does not include its children
+    auto & root = paths.at("object");
+    REQUIRE(root.selfNs <= root.inclusiveNs);
+    REQUIRE(root.inclusiveNs >= paths.at("object/x").inclusiveNs + paths.at("object/points").inclusiveNs);
+    REQUIRE(root.inclusiveNs - root.selfNs == paths.at("object/x").inclusiveNs + paths.at("object/points").inclusiveNs);
+
+    // the root is always the hottest by inclusive time
+    auto hot = WidgetProfiler::hottest(paths, 2);
+    REQUIRE(hot.size() == 2);
+    REQUIRE(hot[0].first == "object");
+    REQUIRE(hot[0].second.inclusiveNs >= hot[1].second.inclusiveNs);
+    REQUIRE(WidgetProfiler::hottest(paths, 100).size() == 4);
+}
+
+TEST_CASE("WidgetProfiler - window of frames")
+{
+    using namespace ImJSchema;
+
+    WidgetProfiler P(2);
+
+    auto _frame = [&](char const * label)
+    {
+        P.beginWidget(label);
+        P.endWidget("object", "");
+        P.endFrame();
+    };
+
+    _frame("a");
+    _frame("a");
+    REQUIRE(P.paths().at("a").calls == 2);
+
+    // the oldest frame is dropped, along with paths no longer drawn
+    _frame("b");
+    REQUIRE(P.frameCount() == 2);
+    REQUIRE(P.paths().at("a").calls == 1);
+    REQUIRE(P.paths().at("b").calls == 1);
+
+    _frame("b");
+    REQUIRE(P.paths().count("a") == 0);
+    REQUIRE(P.paths().at("b").calls == 2);
+    REQUIRE(P.widgets().at("object/").calls == 2);
+
+    P.clear();
+    REQUIRE(P.frameCount() == 0);
+    REQUIRE(P.paths().empty());
+    REQUIRE(P.widgets().empty());
+}
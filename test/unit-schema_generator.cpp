@@ -0,0 +1,75 @@
+#include <catch2/catch_all.hpp>
+
+#include <string>
+
+#include "ImJSchema/detail/json_utils.h"
+#include "ImJSchema/detail/validator.h"
+#include "generator/schema_generator.h"
+
+TEST_CASE("generateSchema - deterministic")
+{
+    using namespace ImJSchema;
+
+    generator::SchemaGeneratorOptions opt;
+    opt.seed = 7;
+    REQUIRE(generator::generateSchema(opt) == generator::generateSchema(opt));
+
+    auto S = generator::generateSchema(opt);
+    opt.seed = 8;
+    REQUIRE(generator::generateSchema(opt) != S);
+
+    REQUIRE(generator::generateValue(S, 3) == generator::generateValue(S, 3));
+    REQUIRE(generator::generateValue(S, 3) != generator::generateValue(S, 4));
+}
+
+TEST_CASE("generateSchema - shape")
+{
+    using namespace ImJSchema;
+
+    generator::SchemaGeneratorOptions opt;
+    opt.depth       = 3;
+    opt.breadth     = 5;
+    opt.arrayLength = 6;
+    opt.enumCount   = 9;
+    opt.defCount    = 3;
+    opt.refFanOut   = 2;
+    opt.oneOfCount  = 4;
+
+    auto S = generator::generateSchema(opt);
+    REQUIRE(S["$defs"].size() == 3);
+
+    // breadth + refs + oneOf + child + list
+    auto & P = S["properties"];
+    REQUIRE(P.size() == 5 + 2 + 1 + 2);
+    REQUIRE(P["choice"]["oneOf"].size() == 4);
+    REQUIRE(P["list"]["minItems"] == 6);
+    REQUIRE(P["child"]["properties"].contains("child"));
+    REQUIRE(!P["child"]["properties"]["child"]["properties"].contains("child"));
+
+    // the generated value is valid for the expanded schema
+    auto E = S;
+    jsonExpandAllReferences(E);
+    auto V = compileValidator(E);
+    for(uint32_t seed = 1; seed < 5; seed++)
+    {
+        auto value = generator::generateValue(S, seed);
+        ValidationErrors errors;
+        std::string report;
+        if(!validate(V, value, errors))
+        {
+            for(auto & [path, messages] : errors)
+                report += path + ": " + messages.front() + "\n";
+        }
+        CAPTURE(seed);
+        INFO(report);
+        REQUIRE(errors.empty());
+        REQUIRE(value["list"].size() == 6);
+        REQUIRE(value["child"]["list"].size() == 6);
+    }
+
+    // initializeToDefaults creates the arrays with the same length
+    json D;
+    initializeToDefaults(D, E);
+    REQUIRE(D["list"].size() == 6);
+    REQUIRE(D["child"]["list"][5]["list"].empty());
+}
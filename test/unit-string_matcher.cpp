@@ -0,0 +1,95 @@
+#include <catch2/catch_all.hpp>
+
+#include <random>
+
+#include "ImJSchema/detail/string_matcher.h"
+
+TEST_CASE("StringMatcher - matches the same strings as std::regex")
+{
+    using namespace ImJSchema;
+
+    std::vector<std::string> patterns = {
+        "a+", "^a+$", "^[a-z]+$", "^\\d{3}-\\d{4}$", "(foo|bar)baz", "^(ab|a)*c$", "^$", "", "x*",
+        "^[^0-9]*$", "\\w+@\\w+\\.com", "^.{2,4}$", "^(a|b)?c{1,3}$", "[\\]\\-a]+",
+        "^(?:[01]\\d|2[0-3]):[0-5]\\d$", "a|^b", "c$|d", "^#[0-9a-fA-F]{6}$", "\\s\\S", "[\\d.]+",
+        "(a*)*b", "^a{0,3}$", "(^a|b)", "^[A-Z][a-z]*( [A-Z][a-z]*)*$",
+        // not supported by the DFA
+        "\\bfoo", "(a)\\1", "a(?=b)",
+        // too many DFA states
+        "a[ab]{11}$"
+    };
+
+    std::string const alphabet = "ab c01-9:.@#AZfoxdbrz_\n";
+    std::mt19937 rng(1);
+
+    for(auto & p : patterns)
+    {
+        StringMatcher M(p);
+        std::regex R(p, std::regex::ECMAScript);
+
+        for(int k = 0; k < 2000; k++)
+        {
+            std::string str;
+            auto n = rng() % 14;
+            for(size_t j = 0; j < n; j++)
+                str.push_back(alphabet[rng() % alphabet.size()]);
+
+            if(M.search(str) != std::regex_search(str, R))
+            {
+                CAPTURE(p, str);
+                REQUIRE(M.search(str) == std::regex_search(str, R));
+            }
+        }
+    }
+
+    REQUIRE(!StringMatcher("^[a-z]+$").usesRegex());
+    REQUIRE(StringMatcher("^[a-z]+$").stateCount() > 0);
+    REQUIRE(StringMatcher("(a)\\1").usesRegex());
+    REQUIRE(StringMatcher("a[ab]{11}$").stateCount() == 0);
+
+    REQUIRE_THROWS_AS(StringMatcher("[a-"), std::regex_error);
+}
+
+TEST_CASE("StringMatcherCache")
+{
+    using namespace ImJSchema;
+
+    StringMatcherCache cache;
+    auto a = cache.get("^[a-z]+$");
+    REQUIRE(a);
+    REQUIRE(cache.get("^[a-z]+$") == a);
+    REQUIRE(cache.get("[a-") == nullptr);
+    REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE("matchesFormat")
+{
+    using namespace ImJSchema;
+
+    REQUIRE(matchesFormat("date", "2024-02-29"));
+    REQUIRE(!matchesFormat("date", "2023-02-29"));
+    REQUIRE(!matchesFormat("date", "2024-13-01"));
+    REQUIRE(matchesFormat("time", "13:45:00Z"));
+    REQUIRE(!matchesFormat("time", "24:00:00Z"));
+    REQUIRE(matchesFormat("date-time", "2024-02-29T13:45:00.25+01:00"));
+    REQUIRE(!matchesFormat("date-time", "2024-02-29 13:45:00Z"));
+    REQUIRE(matchesFormat("email", "bob@example.com"));
+    REQUIRE(!matchesFormat("email", "bob@"));
+    REQUIRE(matchesFormat("hostname", "a-b.example"));
+    REQUIRE(!matchesFormat("hostname", "-a.com"));
+    REQUIRE(matchesFormat("ipv4", "192.168.0.1"));
+    REQUIRE(!matchesFormat("ipv4", "192.168.00.1"));
+    REQUIRE(!matchesFormat("ipv4", "256.1.1.1"));
+    REQUIRE(matchesFormat("ipv6", "::1"));
+    REQUIRE(matchesFormat("ipv6", "2001:db8::8a2e:370:7334"));
+    REQUIRE(matchesFormat("ipv6", "::ffff:192.0.2.1"));
+    REQUIRE(!matchesFormat("ipv6", "1:2:3:4:5:6:7"));
+    REQUIRE(!matchesFormat("ipv6", "1::2::3"));
+    REQUIRE(matchesFormat("uri", "https://example.com/a?b"));
+    REQUIRE(!matchesFormat("uri", "//example.com"));
+    REQUIRE(matchesFormat("uuid", "123e4567-e89b-12d3-a456-426614174000"));
+    REQUIRE(!matchesFormat("uuid", "123e4567e89b12d3a456426614174000"));
+
+    // unknown formats are ignored
+    REQUIRE(matchesFormat("color", "not a color"));
+}
@@ -0,0 +1,226 @@
+#include <catch2/catch_all.hpp>
+
+#include "ImJSchema/detail/validator.h"
+
+TEST_CASE("validate - keywords")
+{
+    using namespace ImJSchema;
+
+    auto V = compileValidator(json::parse(R"foo(
+    {
+        "type" : "object",
+        "required" : ["name"],
+        "properties" : {
+            "name"  : { "type" : "string", "minLength" : 2, "maxLength" : 4, "pattern" : "^[a-z]+$" },
+            "count" : { "type" : "integer", "minimum" : 0, "exclusiveMaximum" : 10, "multipleOf" : 2 },
+            "scale" : { "type" : "number", "multipleOf" : 0.1 },
+            "kind"  : { "type" : "string", "enum" : ["a", "b"] },
+            "tags"  : { "type" : "array", "minItems" : 1, "uniqueItems" : true, "items" : { "type" : "string" } }
+        }
+    })foo"));
+
+    ValidationErrors errors;
+    REQUIRE(validate(V, json::parse(R"foo({ "name" : "bob", "count" : 4, "scale" : 0.3, "kind" : "a", "tags" : ["x", "y"] })foo"), errors));
+    REQUIRE(errors.empty());
+
+    // 4 characters, not 8 bytes
+    REQUIRE(validate(V, json::parse(R"foo({ "name" : "éééé", "count" : 2.0 })foo"), errors) == false);
+    REQUIRE(errors.size() == 1);
+    REQUIRE(errors.find("/name")->size() == 1);
+
+    auto value = json::parse(R"foo({ "count" : 3, "scale" : 0.35, "kind" : "c", "tags" : ["x", "x"] })foo");
+    REQUIRE(!validate(V, value, errors));
+    REQUIRE(errors.find("")->size() == 1);         // required
+    REQUIRE(errors.find("/count")->size() == 1);   // multipleOf
+    REQUIRE(errors.find("/scale")->size() == 1);
+    REQUIRE(errors.find("/kind")->size() == 1);
+    REQUIRE(errors.find("/tags")->size() == 1);    // uniqueItems
+    REQUIRE(errors.find("/tags/0") == nullptr);
+
+    value["count"] = "three";
+    value["name"] = "B0B";
+    REQUIRE(!validate(V, value, errors));
+    REQUIRE(errors.find("")  == nullptr);
+    REQUIRE(errors.find("/count")->front() == "must be of type integer");
+    REQUIRE(errors.find("/name")->size() == 1);
+
+    REQUIRE_THROWS(compileValidator(json::parse(R"foo({ "type" : "string", "pattern" : "[a-" })foo")));
+
+    auto D = compileValidator(json::parse(R"foo({ "type" : "string", "format" : "date" })foo"));
+    REQUIRE(validate(D, "2024-02-29", errors));
+    REQUIRE(!validate(D, "2023-02-29", errors));
+    REQUIRE(errors.find("")->front() == "must be a valid date");
+}
+
+TEST_CASE("validate - oneOf")
+{
+    using namespace ImJSchema;
+
+    auto V = compileValidator(json::parse(R"foo(
+    {
+        "type" : "object",
+        "oneOf" : [
+            { "properties" : { "radius" : { "type" : "number", "minimum" : 0 } }, "required" : ["radius"] },
+            { "properties" : { "length" : { "type" : "number", "minimum" : 0 } }, "required" : ["length"] }
+        ]
+    })foo"));
+
+    ValidationErrors errors;
+    REQUIRE(validate(V, json{{"radius", 1}}, errors));
+    REQUIRE(validate(V, json{{"length", 1}}, errors));
+
+    // the errors of the closest alternative are reported
+    REQUIRE(!validate(V, json{{"length", -1}}, errors));
+    REQUIRE(errors.size() == 1);
+    REQUIRE(errors.find("/length") != nullptr);
+
+    // the value must not match more than one alternative
+    auto numbers = compileValidator(json::parse(R"foo({ "oneOf" : [ { "type" : "number" }, { "type" : "integer" } ] })foo"));
+    REQUIRE(validate(numbers, 3.5, errors));
+    REQUIRE(!validate(numbers, 3, errors));
+    REQUIRE(errors.size() == 1);
+    REQUIRE(errors.find("") != nullptr);
+    REQUIRE(!validate(numbers, "3", errors));
+}
+
+TEST_CASE("validate - optional properties which are not enabled")
+{
+    using namespace ImJSchema;
+
+    auto schema = json::parse(R"foo(
+    {
+        "type" : "object",
+        "required" : ["name"],
+        "properties" : {
+            "name" : { "type" : "string", "default" : "bob" },
+            "age"  : { "type" : "integer" }
+        }
+    })foo");
+    auto V = compileValidator(schema);
+
+    // the object widgets access every property with operator[], so
+    // the optional properties which are not enabled are null
+    json value;
+    initializeToDefaults(value, schema);
+    REQUIRE(!value.contains("age"));
+    value["age"];
+    REQUIRE(value["age"].is_null());
+
+    ValidationErrors errors;
+    REQUIRE(validate(V, value, errors));
+    REQUIRE(revalidate(V, value, json::json_pointer("/age"), errors));
+
+    // a required property which is null is missing
+    value["name"] = nullptr;
+    REQUIRE(!validate(V, value, errors));
+    REQUIRE(errors.size() == 1);
+    REQUIRE(errors.find("") != nullptr);
+
+    value["name"] = "bob";
+    value["age"]  = "old";
+    REQUIRE(!validate(V, value, errors));
+    REQUIRE(errors.find("/age") != nullptr);
+}
+
+TEST_CASE("revalidate - only the modified subtree")
+{
+    using namespace ImJSchema;
+
+    auto V = compileValidator(json::parse(R"foo(
+    {
+        "type" : "object",
+        "properties" : {
+            "points" : {
+                "type" : "array",
+                "uniqueItems" : true,
+                "items" : {
+                    "type" : "object",
+                    "required" : ["x"],
+                    "properties" : {
+                        "x" : { "type" : "number", "maximum" : 10 },
+                        "a/b" : { "type" : "string", "minLength" : 1 }
+                    }
+                }
+            },
+            "name" : { "type" : "string", "minLength" : 1 }
+        }
+    })foo"));
+
+    auto value = json::parse(R"foo({ "name" : "", "points" : [ { "x" : 1 }, { "x" : 2 }, { "x" : 3, "a/b" : "" } ] })foo");
+
+    ValidationErrors errors;
+    REQUIRE(!validate(V, value, errors));
+    REQUIRE(errors.size() == 2);
+    REQUIRE(errors.find("/name") != nullptr);
+    REQUIRE(errors.find("/points/2/a~1b") != nullptr);
+
+    // invalid edit
+    value["points"][1]["x"] = 20;
+    REQUIRE(!revalidate(V, value, json::json_pointer("/points/1/x"), errors));
+    REQUIRE(errors.size() == 3);
+    REQUIRE(errors.find("/points/1/x") != nullptr);
+
+    // the parents' own constraints are checked
+    value["points"][1] = value["points"][0];
+    REQUIRE(!revalidate(V, value, json::json_pointer("/points/1"), errors));
+    REQUIRE(errors.find("/points/1/x") == nullptr);
+    REQUIRE(errors.find("/points") != nullptr);
+
+    value["points"][1]["x"] = 5;
+    value["points"][2]["a/b"] = "c";
+    value["name"] = "bob";
+    revalidate(V, value, json::json_pointer("/points/1/x"), errors);
+    revalidate(V, value, json::json_pointer("/points/2/a~1b"), errors);
+    REQUIRE(revalidate(V, value, json::json_pointer("/name"), errors));
+    REQUIRE(errors.empty());
+
+    // removed values revalidate their parent
+    value["points"][2].erase("x");
+    REQUIRE(!revalidate(V, value, json::json_pointer("/points/2/x"), errors));
+    REQUIRE(errors.find("/points/2")->size() == 1);
+
+    // the result is the same as validating the entire value
+    ValidationErrors full;
+    validate(V, value, full);
+    REQUIRE(std::equal(full.begin(), full.end(), errors.begin(), errors.end()));
+}
+
+TEST_CASE("validate - arrays of numbers")
+{
+    using namespace ImJSchema;
+
+    auto V = compileValidator(json::parse(R"foo(
+    {
+        "type" : "object",
+        "properties" : {
+            "curve"   : { "type" : "array", "items" : { "type" : "number",  "minimum" : 0, "exclusiveMaximum" : 1 } },
+            "indices" : { "type" : "array", "items" : { "type" : "integer", "maximum" : 100 } }
+        }
+    })foo"));
+
+    json value;
+    auto & curve   = value["curve"];
+    auto & indices = value["indices"];
+    for(int i = 0; i < 1000; i++)
+    {
+        curve.push_back(i / 1000.0);
+        indices.push_back(i % 100);
+    }
+
+    ValidationErrors errors;
+    REQUIRE(validate(V, value, errors));
+
+    curve[3]   = 1.0;
+    curve[500] = -0.5;
+    curve[999] = "x";
+    indices[7]   = 2.0;     // an integer stored as a float is valid
+    indices[8]   = 2.5;
+    indices[900] = 101;
+    REQUIRE(!validate(V, value, errors));
+    REQUIRE(errors.size() == 5);
+    REQUIRE(errors.find("/curve/3")->front() == "must be < 1");
+    REQUIRE(errors.find("/curve/500")->front() == "must be >= 0");
+    REQUIRE(errors.find("/curve/999")->front() == "must be of type number");
+    REQUIRE(errors.find("/indices/8")->front() == "must be of type integer");
+    REQUIRE(errors.find("/indices/900")->front() == "must be <= 100");
+}
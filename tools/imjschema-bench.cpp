@@ -0,0 +1,461 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// imjschema-bench: draws forms for a number of frames with an ImGui
+// context that has no window and no renderer, and reports the time,
+// the number of widgets and the number of heap allocations per frame.
+//
+//   imjschema-bench [options] [schema.json or directory]...
+//
+// The share/ examples are used if no schemas are given. With --scaling,
+// synthetic schemas are generated with one of their parameters
+// increasing, and the cost of expanding the references, applying
+// the defaults and drawing is reported for each one.
+//
+// With --budget, the exit code is 1 if a frame of any compiled schema
+// makes more allocations than the budget, eg: to catch regressions in CI.
+//
+#define IMGUI_DEFINE_MATH_OPERATORS
+#include <ImJSchema/ImJSchema.h>
+
+// Every operator new is counted, which includes the allocations made by
+// nlohmann json and the std containers used by ImJSchema. ImGui allocates
+// with malloc through its own allocator, so it is not.
+#define IMJSCHEMA_IMPLEMENT_ALLOCATION_HOOKS
+#include <ImJSchema/detail/allocation_hooks.h>
+
+#include <imgui.h>
+
+#include <generator/schema_generator.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace IJS = ImJSchema;
+namespace fs  = std::filesystem;
+
+#ifndef IMJSCHEMA_SHARE_DIR
+#define IMJSCHEMA_SHARE_DIR "share"
+#endif
+
+namespace
+{
+
+struct Options
+{
+    std::vector<std::string> inputs;
+    size_t frames      = 500;
+    size_t warmup      = 10;       // frames drawn before measuring
+    size_t synthetic   = 32;       // length of the synthetic schema's arrays, 0 to skip it
+    bool   compiledOnly = false;
+    std::string scaling;           // parameter of the generator to increase
+    double budget = std::numeric_limits<double>::infinity();    // allocations per compiled frame
+};
+
+struct Input
+{
+    std::string name;
+    IJS::json   schema;
+    IJS::json   value;             // the value drawn, null to start from the defaults
+};
+
+struct Result
+{
+    double   nsPerFrame      = 0.0;
+    double   widgetsPerFrame = 0.0;
+    double   allocsPerFrame  = 0.0;
+    double   bytesPerFrame   = 0.0;
+};
+
+void printUsage()
+{
+    std::cout <<
+        "usage: imjschema-bench [options] [schema.json or directory]...\n"
+        "\n"
+        "Draws each schema with a headless ImGui context and reports the time,\n"
+        "widgets and heap allocations per frame. The schemas in " IMJSCHEMA_SHARE_DIR "\n"
+        "are used if none are given.\n"
+        "\n"
+        "options:\n"
+        "  -n, --frames <n>       number of frames measured per schema, default: 500\n"
+        "  -w, --warmup <n>       number of frames drawn before measuring, default: 10\n"
+        "  -s, --synthetic <n>    length of the arrays in the synthetic schema,\n"
+        "                         0 to skip it, default: 32\n"
+        "  -c, --compiled-only    only draw the compiled schemas\n"
+        "      --scaling <param>  draw synthetic schemas with an increasing parameter:\n"
+        "                         depth, breadth, array, enum, refs or oneof\n"
+        "      --budget <n>       exit with 1 if a frame of a compiled schema makes\n"
+        "                         more than n allocations\n"
+        "  -h, --help             print this message\n";
+}
+
+bool parseOptions(int argc, char ** argv, Options & opt)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto _next = [&]() -> char const*
+        {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+        auto _nextSize = [&](size_t & out)
+        {
+            auto v = _next();
+            if(v)
+                out = static_cast<size_t>(std::strtoull(v, nullptr, 10));
+            return v != nullptr;
+        };
+
+        if(arg == "-h" || arg == "--help")
+            return false;
+        else if(arg == "-n" || arg == "--frames")
+        {
+            if(!_nextSize(opt.frames))
+                return false;
+        }
+        else if(arg == "-w" || arg == "--warmup")
+        {
+            if(!_nextSize(opt.warmup))
+                return false;
+        }
+        else if(arg == "-s" || arg == "--synthetic")
+        {
+            if(!_nextSize(opt.synthetic))
+                return false;
+        }
+        else if(arg == "-c" || arg == "--compiled-only")
+            opt.compiledOnly = true;
+        else if(arg == "--scaling")
+        {
+            auto v = _next();
+            if(!v)
+                return false;
+            opt.scaling = v;
+        }
+        else if(arg == "--budget")
+        {
+            auto v = _next();
+            if(!v)
+                return false;
+            opt.budget = std::strtod(v, nullptr);
+        }
+        else
+            opt.inputs.push_back(arg);
+    }
+    opt.frames = std::max<size_t>(opt.frames, 1);
+    return true;
+}
+
+std::vector<Input> loadInputs(Options const & opt)
+{
+    auto paths = opt.inputs;
+    if(paths.empty())
+        paths.push_back(IMJSCHEMA_SHARE_DIR);
+
+    std::vector<std::string> files;
+    for(auto & p : paths)
+    {
+        std::error_code ec;
+        if(fs::is_directory(p, ec))
+        {
+            for(auto & e : fs::directory_iterator(p, ec))
+            {
+                if(e.path().extension() == ".json")
+                    files.push_back(e.path().string());
+            }
+        }
+        else
+        {
+            files.push_back(p);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<Input> inputs;
+    for(auto & f : files)
+    {
+        Input I;
+        I.name = fs::path(f).filename().string();
+        try
+        {
+            if(!IJS::JsonDocumentCache::loadFile(f, I.schema))
+            {
+                std::cerr << f << ": could not be loaded" << std::endl;
+                continue;
+            }
+            IJS::JsonDocumentCache documents;
+            IJS::jsonExpandAllReferences(I.schema, documents, f);
+        }
+        catch(std::exception & e)
+        {
+            std::cerr << f << ": " << e.what() << std::endl;
+            continue;
+        }
+        inputs.push_back(std::move(I));
+    }
+
+    if(opt.synthetic)
+    {
+        IJS::generator::SchemaGeneratorOptions G;
+        G.arrayLength = static_cast<uint32_t>(opt.synthetic);
+        Input I;
+        I.name   = "synthetic/" + std::to_string(opt.synthetic);
+        I.schema = IJS::generator::generateSchema(G);
+        I.value  = IJS::generator::generateValue(I.schema, G.seed, G.arrayLength);
+        IJS::jsonExpandAllReferences(I.schema);
+        inputs.push_back(std::move(I));
+    }
+    return inputs;
+}
+
+/**
+ * @brief measure
+ * @param opt
+ * @param ctx
+ * @param drawFrame
+ * @return
+ *
+ * Draws opt.warmup + opt.frames frames, each frame is a full
+ * NewFrame/Render with a window covering the display.
+ */
+template<typename F>
+Result measure(Options const & opt, IJS::Context & ctx, F && drawFrame)
+{
+    auto _frame = [&]()
+    {
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos({0, 0});
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin("imjschema-bench");
+        drawFrame();
+        ImGui::End();
+        ImGui::Render();
+    };
+
+    for(size_t i = 0; i < opt.warmup; i++)
+        _frame();
+
+    auto widgets = ctx.widgetCount;
+    auto allocs  = IJS::threadAllocationStats();
+    auto t0      = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < opt.frames; i++)
+        _frame();
+
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    allocs  = IJS::threadAllocationStats() - allocs;
+
+    auto n = static_cast<double>(opt.frames);
+    Result R;
+    R.nsPerFrame      = ns / n;
+    R.widgetsPerFrame = static_cast<double>(ctx.widgetCount - widgets) / n;
+    R.allocsPerFrame  = static_cast<double>(allocs.count) / n;
+    R.bytesPerFrame   = static_cast<double>(allocs.bytes) / n;
+    return R;
+}
+
+void printResult(std::string const & name, char const * mode, Result const & R)
+{
+    std::printf("%-28s %-9s %12.0f %10.1f %10.1f %12.1f\n",
+                name.c_str(), mode, R.nsPerFrame, R.widgetsPerFrame, R.allocsPerFrame, R.bytesPerFrame);
+    std::fflush(stdout);
+}
+
+/**
+ * @brief runScaling
+ * @param opt
+ * @return
+ *
+ * Generates schemas with the opt.scaling parameter increasing and the
+ * others at their defaults. For each one, prints the time to expand the
+ * references, to apply the defaults, and to draw a frame of a generated
+ * value with the compiled schema.
+ */
+int runScaling(Options const & opt)
+{
+    using G = IJS::generator::SchemaGeneratorOptions;
+    struct Sweep
+    {
+        char const *          name;
+        uint32_t G::*         member;
+        std::vector<uint32_t> values;
+    };
+    std::vector<Sweep> const sweeps = {
+        {"depth",   &G::depth,       {1, 2, 3, 4, 5}},
+        {"breadth", &G::breadth,     {1, 4, 16, 64, 256}},
+        {"array",   &G::arrayLength, {1, 4, 16, 64, 256}},
+        {"enum",    &G::enumCount,   {2, 8, 32, 128, 512}},
+        {"refs",    &G::refFanOut,   {0, 1, 4, 16, 64}},
+        {"oneof",   &G::oneOfCount,  {0, 2, 8, 32, 128}},
+    };
+
+    auto sweep = std::find_if(sweeps.begin(), sweeps.end(), [&](Sweep const & w) { return opt.scaling == w.name; });
+    if(sweep == sweeps.end())
+    {
+        std::cerr << "unknown scaling parameter: " << opt.scaling << std::endl;
+        return 2;
+    }
+
+    constexpr size_t reps = 5;
+    auto _elapsedUs = [](std::chrono::steady_clock::time_point t0)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    std::printf("%-8s %8s %10s %12s %12s %12s %10s %10s\n",
+                "param", "value", "nodes", "expand us", "defaults us", "ns/frame", "widgets", "allocs");
+
+    for(auto v : sweep->values)
+    {
+        G g;
+        g.*(sweep->member) = v;
+        auto schema = IJS::generator::generateSchema(g);
+
+        double expandUs = 0.0;
+        IJS::json expanded;
+        for(size_t r = 0; r < reps; r++)
+        {
+            expanded = schema;
+            auto t0 = std::chrono::steady_clock::now();
+            IJS::jsonExpandAllReferences(expanded);
+            expandUs += _elapsedUs(t0);
+        }
+
+        double defaultsUs = 0.0;
+        for(size_t r = 0; r < reps; r++)
+        {
+            IJS::json D;
+            auto t0 = std::chrono::steady_clock::now();
+            IJS::initializeToDefaults(D, expanded);
+            defaultsUs += _elapsedUs(t0);
+        }
+
+        IJS::Context ctx;
+        IJS::FormState state;
+        auto value    = IJS::generator::generateValue(schema, g.seed, g.arrayLength);
+        auto compiled = IJS::compileSchema(expanded);
+        auto R = measure(opt, ctx, [&]() { IJS::drawSchemaWidget(ctx, compiled, value, state); });
+
+        std::printf("%-8s %8u %10zu %12.1f %12.1f %12.0f %10.1f %10.1f\n",
+                    sweep->name, v, compiled.nodes.size(),
+                    expandUs / reps, defaultsUs / reps,
+                    R.nsPerFrame, R.widgetsPerFrame, R.allocsPerFrame);
+        std::fflush(stdout);
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+    Options opt;
+    if(!parseOptions(argc, argv, opt))
+    {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<Input> inputs;
+    if(opt.scaling.empty())
+    {
+        inputs = loadInputs(opt);
+        if(inputs.empty())
+        {
+            std::cerr << "no schemas to draw" << std::endl;
+            return 2;
+        }
+    }
+
+    // a context without a window or a renderer, the draw
+    // lists are built every frame but never rendered
+    ImGui::CreateContext();
+    auto & io = ImGui::GetIO();
+    io.DisplaySize = {1920.0f, 1080.0f};
+    io.DeltaTime   = 1.0f / 60.0f;
+    io.IniFilename = nullptr;
+    {
+        unsigned char * pixels = nullptr;
+        int w = 0, h = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &w, &h);
+    }
+
+    if(!opt.scaling.empty())
+    {
+        auto r = runScaling(opt);
+        ImGui::DestroyContext();
+        return r;
+    }
+
+    std::printf("%-28s %-9s %12s %10s %10s %12s\n", "schema", "mode", "ns/frame", "widgets", "allocs", "bytes");
+
+    int exitCode = 0;
+    for(auto & I : inputs)
+    {
+        if(!opt.compiledOnly)
+        {
+            IJS::Context ctx;
+            IJS::json value = I.value, cache;
+            IJS::WidgetDrawInput in{"object", value, I.schema, cache};
+            in.ctx = &ctx;
+            auto R = measure(opt, ctx, [&]() { IJS::drawSchemaWidget(in); });
+            printResult(I.name, "json", R);
+        }
+
+        {
+            IJS::Context ctx;
+            IJS::json value = I.value;
+            IJS::FormState state;
+            auto compiled = IJS::compileSchema(I.schema);
+            auto R = measure(opt, ctx, [&]() { IJS::drawSchemaWidget(ctx, compiled, value, state); });
+            printResult(I.name, "compiled", R);
+
+            if(R.allocsPerFrame > opt.budget)
+            {
+                std::printf("%s: %.1f allocations per frame, the budget is %.1f\n", I.name.c_str(), R.allocsPerFrame, opt.budget);
+                exitCode = 1;
+            }
+        }
+    }
+
+    ImGui::DestroyContext();
+    return exitCode;
+}
+
+// The ImGui sources are compiled into the benchmark, the same as main.cpp
+#include <imgui_demo.cpp>
+#include <imgui_widgets.cpp>
+#include <imgui_draw.cpp>
+#include <imgui_tables.cpp>
+#include <imgui.cpp>
+#include <imgui_stdlib.cpp>
@@ -0,0 +1,136 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// imjschema-generate: writes a synthetic schema, and optionally a value
+// which is valid for it, eg: to test the editor or imjschema-validate
+// with large inputs. The same options always write the same files.
+//
+//   imjschema-generate [options] <schema.json> [value.json]
+//
+#include <generator/schema_generator.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace gen = ImJSchema::generator;
+
+namespace
+{
+
+void printUsage()
+{
+    gen::SchemaGeneratorOptions d;
+    std::cout <<
+        "usage: imjschema-generate [options] <schema.json> [value.json]\n"
+        "\n"
+        "Writes a synthetic schema, and a value which is valid for it if a second\n"
+        "file is given.\n"
+        "\n"
+        "options:\n"
+        "  --seed <n>      seed of the random numbers, default: " << d.seed << "\n"
+        "  --depth <n>     levels of nested objects, default: " << d.depth << "\n"
+        "  --breadth <n>   leaf properties per object, default: " << d.breadth << "\n"
+        "  --array <n>     minItems of the arrays, default: " << d.arrayLength << "\n"
+        "  --enum <n>      values of each enum, default: " << d.enumCount << "\n"
+        "  --defs <n>      number of $defs, default: " << d.defCount << "\n"
+        "  --refs <n>      $ref properties per object, default: " << d.refFanOut << "\n"
+        "  --oneof <n>     alternatives of the oneOf property of each object, default: " << d.oneOfCount << "\n"
+        "  --indent <n>    indentation of the written json, -1 for none, default: 4\n"
+        "  -h, --help      print this message\n";
+}
+
+bool write(std::string const & path, gen::json const & J, int indent)
+{
+    std::ofstream out(path);
+    out << J.dump(indent) << "\n";
+    if(!out)
+    {
+        std::cerr << path << ": could not be written" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+    gen::SchemaGeneratorOptions opt;
+    int indent = 4;
+    std::vector<std::string> files;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        uint32_t * member = nullptr;
+        if(arg == "--seed")         member = &opt.seed;
+        else if(arg == "--depth")   member = &opt.depth;
+        else if(arg == "--breadth") member = &opt.breadth;
+        else if(arg == "--array")   member = &opt.arrayLength;
+        else if(arg == "--enum")    member = &opt.enumCount;
+        else if(arg == "--defs")    member = &opt.defCount;
+        else if(arg == "--refs")    member = &opt.refFanOut;
+        else if(arg == "--oneof")   member = &opt.oneOfCount;
+
+        if(member || arg == "--indent")
+        {
+            if(i + 1 >= argc)
+            {
+                printUsage();
+                return 2;
+            }
+            auto v = std::strtol(argv[++i], nullptr, 10);
+            if(member)
+                *member = static_cast<uint32_t>(v);
+            else
+                indent = static_cast<int>(v);
+        }
+        else if(arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 2;
+        }
+        else
+        {
+            files.push_back(arg);
+        }
+    }
+
+    if(files.empty() || files.size() > 2)
+    {
+        printUsage();
+        return 2;
+    }
+
+    auto schema = gen::generateSchema(opt);
+    if(!write(files[0], schema, indent))
+        return 1;
+    if(files.size() == 2 && !write(files[1], gen::generateValue(schema, opt.seed, opt.arrayLength), indent))
+        return 1;
+    return 0;
+}
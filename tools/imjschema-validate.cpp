@@ -0,0 +1,306 @@
+/**
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 GavinNL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+//
+// imjschema-validate: validates json documents against a schema
+// without drawing anything, eg: to check the files written by the
+// editor in CI.
+//
+//   imjschema-validate [options] <schema.json> <file or directory>...
+//
+#include <ImJSchema/detail/json_utils.h>
+#include <ImJSchema/detail/validator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace IJS = ImJSchema;
+namespace fs  = std::filesystem;
+
+namespace
+{
+
+struct Options
+{
+    std::string              schema;
+    std::vector<std::string> inputs;
+    std::string              extension = ".json";
+    size_t                   threads   = 0;     // 0 uses all cores
+    bool                     quiet     = false;
+};
+
+struct FileResult
+{
+    std::string          path;
+    size_t               bytes  = 0;
+    bool                 read   = false;
+    bool                 parsed = false;
+    IJS::ValidationErrors errors;
+};
+
+// exit codes
+constexpr int exitValid       = 0;
+constexpr int exitInvalid     = 1;
+constexpr int exitSchemaError = 2;
+constexpr int exitCommandLine = 3;
+
+enum class ParseResult
+{
+    Ok,
+    Help,
+    Error
+};
+
+void printUsage(std::ostream & out)
+{
+    out <<
+        "usage: imjschema-validate [options] <schema.json> <file or directory>...\n"
+        "\n"
+        "Validates json documents against a json schema. Directories are\n"
+        "searched recursively. $ref to other files are resolved relative\n"
+        "to the schema.\n"
+        "\n"
+        "options:\n"
+        "  -j, --threads <n>      number of threads, default: all cores\n"
+        "  -e, --extension <ext>  extension of the files in the directories, default: .json\n"
+        "  -q, --quiet            only print the files that are invalid and the summary\n"
+        "  -h, --help             print this message\n"
+        "\n"
+        "Returns 0 if every document is valid (or with --help), 1 if any\n"
+        "document is invalid or could not be parsed, 2 if the schema could\n"
+        "not be loaded, and 3 if the command line is not valid.\n";
+}
+
+ParseResult parseOptions(int argc, char ** argv, Options & opt)
+{
+    std::vector<std::string> positional;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto _next = [&]() -> char const*
+        {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+
+        if(arg == "-h" || arg == "--help")
+        {
+            return ParseResult::Help;
+        }
+        else if(arg == "-j" || arg == "--threads")
+        {
+            auto v = _next();
+            if(!v)
+            {
+                std::cerr << arg << " needs a value" << std::endl;
+                return ParseResult::Error;
+            }
+            opt.threads = static_cast<size_t>(std::strtoul(v, nullptr, 10));
+        }
+        else if(arg == "-e" || arg == "--extension")
+        {
+            auto v = _next();
+            if(!v)
+            {
+                std::cerr << arg << " needs a value" << std::endl;
+                return ParseResult::Error;
+            }
+            opt.extension = v;
+        }
+        else if(arg == "-q" || arg == "--quiet")
+        {
+            opt.quiet = true;
+        }
+        else if(arg.size() > 1 && arg.front() == '-')
+        {
+            std::cerr << "unknown option: " << arg << std::endl;
+            return ParseResult::Error;
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+    if(positional.size() < 2)
+    {
+        std::cerr << "a schema and at least one file or directory are required" << std::endl;
+        return ParseResult::Error;
+    }
+
+    opt.schema = positional.front();
+    opt.inputs.assign(positional.begin() + 1, positional.end());
+    return ParseResult::Ok;
+}
+
+std::vector<std::string> findFiles(Options const & opt)
+{
+    std::vector<std::string> files;
+    for(auto & input : opt.inputs)
+    {
+        std::error_code ec;
+        if(fs::is_directory(input, ec))
+        {
+            for(auto & e : fs::recursive_directory_iterator(input, fs::directory_options::skip_permission_denied, ec))
+            {
+                if(e.is_regular_file(ec) && e.path().extension() == opt.extension)
+                    files.push_back(e.path().string());
+            }
+        }
+        else
+        {
+            files.push_back(input);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+    Options opt;
+    switch(parseOptions(argc, argv, opt))
+    {
+        case ParseResult::Ok:
+            break;
+        case ParseResult::Help:
+            printUsage(std::cout);
+            return exitValid;
+        case ParseResult::Error:
+            printUsage(std::cerr);
+            return exitCommandLine;
+    }
+
+    // load the schema the same way as the editor: expand
+    // the references, then compile it once
+    IJS::CompiledValidator V;
+    try
+    {
+        IJS::json schema;
+        if(!IJS::JsonDocumentCache::loadFile(opt.schema, schema))
+        {
+            std::cerr << opt.schema << ": could not load the schema" << std::endl;
+            return exitSchemaError;
+        }
+        IJS::JsonDocumentCache documents;
+        IJS::jsonExpandAllReferences(schema, documents, opt.schema);
+        V = IJS::compileValidator(std::move(schema));
+    }
+    catch(std::exception & e)
+    {
+        std::cerr << opt.schema << ": " << e.what() << std::endl;
+        return exitSchemaError;
+    }
+
+    auto files = findFiles(opt);
+    std::vector<FileResult> results(files.size());
+
+    auto threadCount = opt.threads ? opt.threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, std::max<size_t>(1, files.size()));
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    // each thread takes the next file, the validator is shared
+    std::atomic<size_t> next{0};
+    auto _worker = [&]()
+    {
+        IJS::json value;
+        for(size_t i = next++; i < files.size(); i = next++)
+        {
+            auto & R = results[i];
+            R.path = files[i];
+
+            std::error_code ec;
+            R.bytes = static_cast<size_t>(fs::file_size(R.path, ec));
+            R.read  = !ec;
+            if(!R.read)
+            {
+                R.bytes = 0;
+                continue;
+            }
+
+            R.parsed = IJS::JsonDocumentCache::loadFile(R.path, value);
+            if(R.parsed)
+                IJS::validate(V, value, R.errors);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < threadCount; t++)
+        threads.emplace_back(_worker);
+    _worker();
+    for(auto & t : threads)
+        t.join();
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    size_t valid = 0, invalid = 0, unreadable = 0, bytes = 0;
+    for(auto & R : results)
+    {
+        bytes += R.bytes;
+        if(!R.parsed)
+        {
+            unreadable++;
+            std::cout << R.path << (R.read ? ": could not be parsed" : ": could not be read") << std::endl;
+        }
+        else if(!R.errors.empty())
+        {
+            invalid++;
+            std::cout << R.path << ": invalid" << std::endl;
+            if(!opt.quiet)
+            {
+                for(auto & [path, messages] : R.errors)
+                {
+                    for(auto & m : messages)
+                        std::cout << "    " << (path.empty() ? "/" : path) << ": " << m << "\n";
+                }
+            }
+        }
+        else
+        {
+            valid++;
+            if(!opt.quiet)
+                std::cout << R.path << ": valid\n";
+        }
+    }
+
+    auto _rate = [&](double x) { return seconds > 0.0 ? x / seconds : 0.0; };
+    std::printf("\n%zu documents: %zu valid, %zu invalid, %zu could not be read or parsed\n", results.size(), valid, invalid, unreadable);
+    std::printf("%.3f s on %zu threads, %.1f docs/sec, %.2f MB/sec\n",
+                seconds, threadCount,
+                _rate(static_cast<double>(results.size())),
+                _rate(static_cast<double>(bytes) / (1024.0 * 1024.0)));
+
+    return (invalid || unreadable) ? exitInvalid : exitValid;
+}